@@ -0,0 +1,146 @@
+/******************************************************************************
+Bit-packed cellular automaton engine: a cell's state is split over bit planes
+(one bit per cell per plane), 64 cells to a word, so a rule is evaluated for
+64 cells at once with plain bitwise word operations. Double-buffered. Cells
+outside the grid are all-zero (dead) and stay that way.
+******************************************************************************/
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/*****************************************************************************/
+
+template <size_t Planes>
+struct Automaton {
+    typedef uint64_t Word;
+    typedef std::array<Word, Planes> Words;  // 64 cells, all planes
+    constexpr static size_t Bits{64};
+
+    size_t rows, cols;                            // grid size in cells
+    size_t words;                                 // words per row
+    size_t stride;                                // ... plus 2 guard words
+    std::vector<Word> mask;                       // valid cells of each word
+    std::array<std::vector<Word>, Planes> cells;  // current generation
+    std::array<std::vector<Word>, Planes> next;   // next generation
+
+    // A grid with a zero guard row above & below and word left & right, so
+    // neighbourhood reads never need bounds checks.
+    Automaton(size_t rows, size_t cols)
+        : rows(rows),
+          cols(cols),
+          words((cols + Bits - 1) / Bits),
+          stride(words + 2),
+          mask(words, ~Word{0}) {
+        if (cols % Bits)
+            mask.back() = (Word{1} << (cols % Bits)) - 1;
+        for (size_t p = 0; p < Planes; ++p)
+            cells[p].assign((rows + 2) * stride, 0), next[p] = cells[p];
+    }
+
+    // single cell access
+    size_t word(size_t y, size_t x) const {
+        return (y + 1) * stride + x / Bits + 1;
+    }
+    bool get(size_t p, size_t y, size_t x) const {
+        return (cells[p][word(y, x)] >> (x % Bits)) & 1;
+    }
+    void set(size_t p, size_t y, size_t x, bool on = true) {
+        Word bit{Word{1} << (x % Bits)};
+        cells[p][word(y, x)] = on ? (cells[p][word(y, x)] | bit)
+                                  : (cells[p][word(y, x)] & ~bit);
+    }
+
+    // # of cells set in a plane
+    size_t count(size_t p) const {
+        size_t n{0};
+        for (Word w : cells[p])
+            n += std::bitset<Bits>(w).count();
+        return n;
+    }
+
+    // call f(y, x) for every cell set in a plane, in reading order
+    template <typename F>
+    void forEach(size_t p, F f) const {
+        for (size_t y = 0; y < rows; ++y)
+            for (size_t w = 0; w < words; ++w)
+                for (Word bits{cells[p][word(y, w * Bits)]}; bits;
+                     bits &= bits - 1)
+                    f(y, w * Bits + std::bitset<Bits>((bits & -bits) - 1)
+                                        .count());
+    }
+
+    // The neighbourhood of 64 cells: at(p, dy, dx) is the word holding, for
+    // every cell, plane p of the cell dy rows down & dx columns right of it
+    // (|dx| < 64).
+    struct Window {
+        const Automaton& a;
+        size_t i;  // index of the centre word
+        Word at(size_t p, int dy, int dx) const {
+            const Word* row{&a.cells[p][i] + dy * std::ptrdiff_t(a.stride)};
+            if (dx > 0)
+                return (row[0] >> dx) | (row[1] << (Bits - dx));
+            if (dx < 0)
+                return (row[0] << -dx) | (row[-1] >> (Bits + dx));
+            return row[0];
+        }
+    };
+
+    // One generation: rule(window) returns the next state words of the
+    // window's 64 cells.
+    template <typename Rule>
+    void step(Rule rule) {
+        for (size_t y = 0; y < rows; ++y)
+            for (size_t w = 0; w < words; ++w) {
+                size_t i{(y + 1) * stride + w + 1};
+                Words out{rule(Window{*this, i})};
+                for (size_t p = 0; p < Planes; ++p)
+                    next[p][i] = out[p] & mask[w];
+            }
+        std::swap(cells, next);
+    }
+
+    /*************************************************************************/
+    // bit-sliced building blocks for rules
+
+    // sum of 8 one-bit words as 4 bit slices (n[0] = least significant)
+    static std::array<Word, 4> sum(const std::array<Word, 8>& in) {
+        std::array<Word, 4> n{};
+        for (Word carry : in)
+            for (size_t s = 0; s < n.size() && carry; ++s) {
+                Word c{n[s] & carry};
+                n[s] ^= carry, carry = c;
+            }
+        return n;
+    }
+
+    // cells whose bit-sliced count n is >= k
+    static Word atLeast(const std::array<Word, 4>& n, unsigned k) {
+        Word gt{0}, eq{~Word{0}};
+        for (size_t s = n.size(); s-- > 0;)
+            if ((k >> s) & 1)
+                eq &= n[s];
+            else
+                gt |= eq & n[s], eq &= ~n[s];
+        return gt | eq;
+    }
+
+    // Lookup table compiled to a tree of bitwise multiplexers: the result
+    // bit of each cell is table[index], where bit j of index is in[j].
+    template <size_t N>
+    static Word lookup(const std::vector<bool>& table,
+                       const std::array<Word, N>& in) {
+        std::array<Word, size_t{1} << N> level;
+        for (size_t i = 0; i < level.size(); ++i)
+            level[i] = table[i] ? ~Word{0} : 0;
+        for (size_t j = 0; j < N; ++j)  // fold on input j (index bit j)
+            for (size_t i = 0; i < level.size() >> (j + 1); ++i)
+                level[i] = (level[2 * i] & ~in[j]) |
+                           (level[2 * i + 1] & in[j]);
+        return level[0];
+    }
+};
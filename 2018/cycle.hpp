@@ -0,0 +1,98 @@
+/******************************************************************************
+Cycle detection & fast-forwarding for iterated processes (automata, ElfCode
+halt values, ...), with Brent's algorithm: O(1) memory, no history table.
+- findCycle(): for a pure function x -> f(x), the cycle start & length.
+- fastForward(): for a stateful simulation identified by a 128-bit hash of
+  its full state (optionally modulo a translation), jump to generation N.
+******************************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+/*****************************************************************************/
+
+// 128-bit hash: two independently seeded multiply-xorshift lanes, mixed
+// with the splitmix64 finalizer
+struct Hash128 {
+    uint64_t lo{0x9e3779b97f4a7c15}, hi{0xc2b2ae3d27d4eb4f};
+
+    static uint64_t mix(uint64_t h) {
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111eb;
+        return h ^ (h >> 31);
+    }
+    Hash128& add(uint64_t w) {
+        lo = mix(lo ^ w) * 0xff51afd7ed558ccd;
+        hi = mix(hi + w) ^ (lo >> 17);
+        return *this;
+    }
+    template <typename It>
+    Hash128& add(It first, It last) {
+        for (; first != last; ++first)
+            add(uint64_t(*first));
+        return *this;
+    }
+    bool operator==(const Hash128& o) const { return lo == o.lo && hi == o.hi; }
+    bool operator!=(const Hash128& o) const { return !(*this == o); }
+};
+
+/*****************************************************************************/
+
+// Brent's cycle detection on x0, f(x0), f(f(x0)), ...: x[mu] is the first
+// value that repeats, lambda the cycle length, and last = x[mu + lambda - 1]
+// the last value before the first repeat.
+template <typename T>
+struct Cycle {
+    uint64_t mu, lambda;
+    T last;
+};
+
+template <typename T, typename F>
+Cycle<T> findCycle(const T& x0, F f) {
+    // find the cycle length: the hare runs ahead, the tortoise teleports to
+    // it at every power of two
+    uint64_t power{1}, lambda{1};
+    T tortoise{x0}, hare{f(x0)};
+    for (; tortoise != hare; ++lambda, hare = f(hare))
+        if (power == lambda)
+            tortoise = hare, power *= 2, lambda = 0;
+
+    // find the cycle start: run both, the hare lambda steps ahead
+    uint64_t mu{0};
+    T last{x0};
+    tortoise = hare = x0;
+    for (uint64_t i = 0; i < lambda; ++i)
+        last = hare, hare = f(hare);
+    for (; tortoise != hare; ++mu)
+        tortoise = f(tortoise), last = hare, hare = f(hare);
+    return {mu, lambda, last};
+}
+
+/*****************************************************************************/
+
+// Step a simulation from generation gen to generation target. key() returns
+// {hash, position}: the hash of the full state with its position factored
+// out (0 if it doesn't move), so a pattern that repeats shifted is a cycle
+// too. Once a cycle is found (Brent: compare with a checkpoint moved to every
+// power-of-two distance), whole periods are skipped and only the remainder
+// is stepped. Returns the position drift of the skipped periods, which the
+// caller adds to its state's own position.
+template <typename Step, typename Key>
+int64_t fastForward(uint64_t gen, uint64_t target, Step step, Key key) {
+    auto [mark, markPos]{key()};
+    uint64_t markGen{gen}, power{1};
+    while (gen < target) {
+        step(), ++gen;
+        auto [hash, pos]{key()};
+        if (hash == mark) {
+            uint64_t period{gen - markGen}, cycles{(target - gen) / period};
+            for (uint64_t rest = (target - gen) % period; rest > 0; --rest)
+                step();
+            return int64_t(cycles) * (pos - markPos);
+        }
+        if (gen - markGen == power)
+            mark = hash, markPos = pos, markGen = gen, power *= 2;
+    }
+    return 0;
+}
@@ -3,11 +3,17 @@
 // https://adventofcode.com/2018/day/1
 
 #include <algorithm>
+#include <array>
 #include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <iterator>
 #include <numeric>
-#include <unordered_set>
+#include <string>
+#include <tuple>
 #include <vector>
 
 // common code (to avoid duplicate code in each solution)
@@ -21,6 +27,8 @@ using frequencies = std::vector<int>;
 // function definitions of the solutions
 int part1(const frequencies& freqs);
 int part2(const frequencies& freqs);
+int part2_dense(const frequencies& freqs);
+long long stream_sum(std::istream& is, frequencies* keep = nullptr);
 
 // more type aliases (for runner template)
 using runner1 = runner<decltype(part1), frequencies, int>;
@@ -37,24 +45,44 @@ const runner1::test_suite suite2{{suite1[0].first, 2},
                                  {{+1, -1}, 0},
                                  {{+3, +3, +4, -2, -4}, 10},
                                  {{-6, +3, +8, +5, -6}, 5},
-                                 {{+7, +7, -2, -7, -4}, 14}};
+                                 {{+7, +7, -2, -7, -4}, 14},
+                                 {{-3, +2}, -3}};
 /*****************************************************************************/
 
 // main: test the examples, parse the input data, solve both parts, then report
-int main() {
+// (--stream: part 1 only, summed while streaming the input, nothing stored;
+// --dense: part 2 with the cycling dense bitmap engine)
+int main(int argc, char* argv[]) {
     // run example tests
     std::cerr << "Running the tests...\n";
     runner1::test(part1, suite1);
     runner1::test(part2, suite2);
+    runner1::test(part2_dense, suite2, false);
 
-    // parse the input data
+    if (argc > 1 && std::string{argv[1]} == "--stream") {
+        std::cerr << "Streaming the input...\n";
+        auto t1{std::chrono::high_resolution_clock::now()};
+        long long sum{stream_sum(std::cin)};
+        auto t2{std::chrono::high_resolution_clock::now()};
+        std::chrono::duration<double, std::milli> ms{t2 - t1};
+        _run_calls++;
+        runner<decltype(part1), frequencies, long long>::report(sum,
+                                                               ms.count());
+        return 0;
+    }
+
+    // parse the input data (the values are only kept for part 2)
     std::cerr << "Parsing the input...\n";
-    const frequencies ids{std::istream_iterator<int>{std::cin}, {}};
+    frequencies ids;
+    stream_sum(std::cin, &ids);
 
     // run, time, and output the solutions
     std::cerr << "Solving the challenge...\n";
     runner1::run(part1, ids);
-    runner1::run(part2, ids);
+    if (argc > 1 && std::string{argv[1]} == "--dense")
+        runner1::run(part2_dense, ids);
+    else
+        runner1::run(part2, ids);
 }
 
 /*****************************************************************************/
@@ -73,16 +101,156 @@ int part1(const frequencies& freqs) {
 // What is the first frequency your device reaches twice?
 // Solution: 394
 //
-// cycle through the partial sum frequencies until we get a recurrence
+// no need to cycle through the partial sums: every frequency ever reached is
+// p + k*drift for a partial sum p of the first pass (index j) and k cycles,
+// at step k*n + j. So a later pass can only ever hit a partial sum in the
+// same residue class (mod drift) on the side the drift moves towards. Sort
+// the partial sums by (residue, value), and each one's nearest neighbour in
+// that direction gives its first collision in closed form: O(n log n), no
+// matter how many cycles it takes. A repeat within the first pass (or zero
+// drift) is the same neighbour search with k = 0. (No collision at all,
+// e.g. {+1}, would cycle forever; 0 is returned.)
 int part2(const frequencies& freqs) {
-    int index{0}, sum{0};
-    std::unordered_set<int> seen{sum};  // first sum is 0
+    const long long n = freqs.size();
+    const long long drift = std::accumulate(freqs.cbegin(), freqs.cend(), 0LL);
+    const long long sign = drift < 0 ? -1 : 1, step = sign * drift;
+
+    // (residue, value, index) of the partial sums, oriented so the drift is
+    // upwards. Zero drift: no cycle shifts anything, but the last partial sum
+    // (0 again) is a repeat within the pass.
+    std::vector<std::tuple<long long, long long, long long>> sums;
+    const long long count{drift ? n : n + 1};
+    long long sum{0};
+    for (long long j = 0; j < count; sum += freqs[j++ % n]) {
+        long long value = sign * sum;
+        long long residue = step ? ((value % step) + step) % step : 0;
+        sums.emplace_back(residue, value, j);
+    }
+    std::sort(sums.begin(), sums.end());
+
+    // the earliest collision among neighbours in a residue class: equal
+    // values repeat at the later index, otherwise the lower partial sum
+    // drifts up to the higher one in (difference / drift) cycles
+    long long first{-1}, repeat{0};
+    for (size_t s = 1; s < sums.size(); ++s) {
+        const auto& [res0, lo, j]{sums[s - 1]};
+        const auto& [res1, hi, i]{sums[s]};
+        if (res0 != res1 || (lo != hi && !step))
+            continue;
+        long long when = lo == hi ? i : (hi - lo) / step * n + j;
+        if (first < 0 || when < first)
+            first = when, repeat = sign * hi;
+    }
+    return repeat;
+}
+
+/*****************************************************************************/
+
+// Set of the frequencies seen so far as a dense bitmap over [lo, lo + 64n),
+// grown geometrically (towards the side that overflowed) to cover new ones.
+// A bit test is a word load instead of a hash probe, and it takes 1 bit per
+// frequency in range instead of a ~64-byte hash node per frequency seen.
+struct SeenBitmap {
+    long long lo{0};             // first frequency covered (multiple of 64)
+    std::vector<uint64_t> bits;  // bit (f - lo) is set if f was seen
+
+    // set the bit of f, return if it was not yet set (like set::insert)
+    bool insert(long long f) {
+        if (f < lo || f >= lo + 64 * (long long)bits.size())
+            grow(f);
+        uint64_t& word{bits[(f - lo) / 64]};
+        uint64_t bit{uint64_t{1} << ((f - lo) % 64)};
+        bool unseen{!(word & bit)};
+        word |= bit;
+        return unseen;
+    }
+
+    // word # of a frequency relative to frequency 0 (floor(f / 64))
+    static long long word_of(long long f) { return (f - (f < 0) * 63) / 64; }
 
-    auto cycle{[&](const auto& v) { return v[index++ % v.size()]; }};
-    auto partial_sums{[&](const auto& f) { return sum += f; }};
-    auto unique{[&](const auto& s) { return std::get<bool>(seen.insert(s)); }};
+    // at least double the size, placing the old bits so f gets covered
+    void grow(long long f) {
+        long long words = bits.size(), first = lo / 64, w = word_of(f);
+        long long size = std::max(2 * words, 16LL);
+        if (words)
+            size = std::max({size, w + 1 - first, first + words - w});
+        long long start = !words      ? w - size / 2
+                          : w < first ? first + words - size
+                                      : first;
+        std::vector<uint64_t> wider(size);
+        std::copy(bits.cbegin(), bits.cend(), wider.begin() + (first - start));
+        bits.swap(wider), lo = start * 64;
+    }
+};
 
-    while (unique(partial_sums(cycle(freqs))))
-        ;
+// Part 2, the direct way with a dense seen-set: cycle through the partial sum
+// frequencies until we get a recurrence. A recurrence k cycles apart needs
+// k * drift <= the first pass's spread, so after that many cycles there is
+// none (returns 0, as part2 does).
+int part2_dense(const frequencies& freqs) {
+    long long sum{0}, lo{0}, hi{0};
+    for (int f : freqs)
+        sum += f, lo = std::min(lo, sum), hi = std::max(hi, sum);
+    const long long drift{std::abs(sum)};
+
+    SeenBitmap seen;
+    seen.insert(sum = 0);
+    for (long long cycle = 0; !drift || cycle <= (hi - lo) / drift + 1; ++cycle)
+        for (int f : freqs)
+            if (!seen.insert(sum += f))
+                return sum;
+    return 0;
+}
+
+/*****************************************************************************/
+
+// Streaming parse & sum of the frequency changes: the input is read in fixed
+// size chunks, the next one on another thread while the current one is
+// parsed (by hand: signed decimals, anything else separates them). Parsed
+// values are staged in a small int32 block, summed with a plain (vectorized)
+// accumulate, and only appended to *keep when the values are needed.
+long long stream_sum(std::istream& is, frequencies* keep) {
+    constexpr size_t chunk_size{1 << 20}, block_size{4096};
+    std::array<std::vector<char>, 2> chunks{std::vector<char>(chunk_size),
+                                            std::vector<char>(chunk_size)};
+    auto read_chunk{[&is](std::vector<char>& chunk) {
+        is.read(chunk.data(), chunk.size());
+        return size_t(is.gcount());
+    }};
+
+    std::array<int32_t, block_size> block;
+    size_t staged{0};
+    long long sum{0};
+    auto flush{[&] {
+        sum += std::accumulate(block.cbegin(), block.cbegin() + staged, 0LL);
+        if (keep)
+            keep->insert(keep->end(), block.cbegin(), block.cbegin() + staged);
+        staged = 0;
+    }};
+
+    // a number may straddle two chunks: the parse state carries over
+    int32_t value{0};
+    bool negative{false}, digits{false};
+    auto emit{[&] {
+        if (digits)
+            block[staged++] = negative ? -value : value;
+        if (staged == block_size)
+            flush();
+        value = 0, negative = digits = false;
+    }};
+
+    auto next{std::async(std::launch::async, read_chunk, std::ref(chunks[0]))};
+    for (size_t c = 0, n; (n = next.get()) > 0; c ^= 1) {
+        next = std::async(std::launch::async, read_chunk,
+                          std::ref(chunks[c ^ 1]));
+        for (const char* p = chunks[c].data(); p != chunks[c].data() + n; ++p)
+            if (*p >= '0' && *p <= '9')
+                value = value * 10 + (*p - '0'), digits = true;
+            else if (*p == '-')
+                negative = true;
+            else if (*p != '+')
+                emit();
+    }
+    emit(), flush();
     return sum;
-}
\ No newline at end of file
+}
@@ -3,14 +3,25 @@
 // https://adventofcode.com/2018/day/2
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
-#include <functional>
+#include <cstdint>
 #include <iostream>
 #include <iterator>
-#include <numeric>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <tuple>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 // common code (to avoid duplicate code in each solution)
 #include "common.hpp"
 
@@ -20,9 +31,40 @@
 using box_id = std::string;
 using box_ids = std::vector<box_id>;
 
+// pairs of ids (indices into the id list)
+using id_pairs = std::vector<std::pair<uint32_t, uint32_t>>;
+
+// box ids packed as fixed-width, zero-padded rows in one contiguous buffer
+// (longer ids are cut short, and flagged: the rows are no use for them)
+struct id_rows {
+    static constexpr size_t width{32};  // max id length (one AVX2 register)
+    size_t count{0};
+    bool truncated{false};        // some id is longer than width
+    std::vector<uint8_t> bytes;
+    std::vector<uint8_t> length;  // id lengths (at most width)
+
+    id_rows() = default;
+    explicit id_rows(const box_ids& ids) : count(ids.size()), length(count) {
+        bytes.assign(count * width, 0);
+        for (size_t i = 0; i < count; i++) {
+            truncated |= ids[i].size() > width;
+            length[i] = uint8_t(std::min(ids[i].size(), width));
+            std::copy_n(ids[i].cbegin(), length[i], bytes.begin() + i * width);
+        }
+    }
+    const uint8_t* operator[](size_t i) const { return &bytes[i * width]; }
+    uint8_t* operator[](size_t i) { return &bytes[i * width]; }
+};
+
 // function definitions of the solutions
 int part1(const box_ids& ids);
+int part1_batched(const box_ids& ids);
 box_id part2(const box_ids& ids);
+id_pairs near_pairs_pairwise(const id_rows& rows, int k, bool first_only);
+id_pairs near_pairs_index(const id_rows& rows, int k);
+box_id part2_index(const box_ids& ids);
+void benchmark_part1(size_t n);
+void benchmark_part2(size_t n);
 
 // more type aliases (for runner template)
 using runner1 = runner<decltype(part1), box_ids, int>;
@@ -42,20 +84,47 @@ const runner2::test_suite suite2{
 /*****************************************************************************/
 
 // main: test the examples, parse the input data, solve both parts, then report
-int main() {
+// (--bench: throughput of the part 1 kernels on 10^7 random ids and of the
+// part 2 index on 10^6 instead; --near k: list all input id pairs within
+// Hamming distance k instead)
+int main(int argc, char* argv[]) {
     // run example tests
     std::cerr << "Running the tests...\n";
     runner1::test(part1, suite1);
     runner2::test(part2, suite2);
+    runner1::test(part1_batched, suite1, false);
+    runner2::test(part2_index, suite2, false);
+
+    if (argc > 1 && std::string{argv[1]} == "--bench") {
+        benchmark_part1(10'000'000);
+        benchmark_part2(1'000'000);
+        return 0;
+    }
 
     // parse the input data
     std::cerr << "Parsing the input...\n";
     const box_ids ids{std::istream_iterator<box_id>{std::cin}, {}};
 
+    if (argc > 2 && std::string{argv[1]} == "--near") {
+        const int k{std::stoi(argv[2])};
+        const id_rows rows{ids};
+        if (rows.truncated) {
+            std::cerr << "Ids longer than " << id_rows::width
+                      << " bytes are not supported by --near\n";
+            return 1;
+        }
+        const id_pairs pairs{near_pairs_index(rows, k)};
+        if (pairs != near_pairs_pairwise(rows, k, false))
+            std::cerr << "Near pair searches disagree!\n", abort();
+        for (auto [a, b] : pairs)
+            std::cout << ids[a] << " " << ids[b] << "\n";
+        return 0;
+    }
+
     // run, time, and output the solutions
     std::cerr << "Solving the challenge...\n";
     runner1::run(part1, ids);
-    runner2::run(part2, ids);
+    runner2::run(part2_index, ids);
 }
 
 /*****************************************************************************/
@@ -66,31 +135,97 @@ int main() {
 //
 // checksum(ids) = #(letter_repeat(id)==2) x #(letter_repeat(id)==3)
 
+// one histogram pass per id: does any letter occur exactly twice / thrice?
+std::pair<bool, bool> letter_repeats(const box_id& id) {
+    std::array<uint8_t, 256> counts{};
+    for (unsigned char c : id)
+        ++counts[c];
+    bool two{false}, three{false};
+    for (unsigned char c : id)
+        two |= counts[c] == 2, three |= counts[c] == 3;
+    return {two, three};
+}
+
 // count box IDs that contain exactly 2 or 3 repeats of any letter
-// product(count_if any_of count_of any_letter in id is in {2,3})
 int part1(const box_ids& ids) {
-    // const box_id alpha{"abcdefghijklmnopqrstuvwxyz"};
-    const auto letter_repeat_counts_to_match = {2, 3};
-    box_id alpha(26, '?');
-    std::iota(alpha.begin(), alpha.end(), 'a');
-
-    auto count_of_any_letter{[&](const auto& id, const auto& cnt) {
-        return any_of(alpha.cbegin(), alpha.cend(), [&](const char& c) {
-            return (cnt == std::count(id.cbegin(), id.cend(), c));
-        });
+    int twos{0}, threes{0};
+    for (const auto& id : ids) {
+        auto [two, three]{letter_repeats(id)};
+        twos += two, threes += three;
+    }
+    return twos * threes;
+}
+
+// The same for fixed-width rows, branch-free: the count of the letter at
+// position j is the # of positions k holding the same byte, and for a fixed
+// k that's one byte compare per j across the whole row. The 32-byte row
+// loops vectorize to one SIMD compare/add each (zero padding never matches
+// a letter). Counts the pairs & triples of ids [first, last).
+std::pair<int, int> letter_repeats(const id_rows& rows, size_t first,
+                                   size_t last) {
+    constexpr size_t W{id_rows::width};
+    int twos{0}, threes{0};
+    for (size_t i = first; i < last; i++) {
+        const uint8_t* row{rows[i]};
+        alignas(W) uint8_t counts[W]{};
+        for (size_t k = 0; k < W && row[k]; k++)
+            for (size_t j = 0; j < W; j++)
+                counts[j] += row[j] == row[k];
+        uint8_t two{0}, three{0};
+        for (size_t j = 0; j < W; j++)
+            two |= counts[j] == 2, three |= counts[j] == 3;
+        twos += two, threes += three;
+    }
+    return {twos, threes};
+}
+
+// part 1 on fixed-width rows (or the histograms, for ids too long for them)
+int part1_batched(const box_ids& ids) {
+    const id_rows rows{ids};
+    if (rows.truncated)
+        return part1(ids);
+    auto [twos, threes]{letter_repeats(rows, 0, rows.count)};
+    return twos * threes;
+}
+
+// Throughput of both part 1 kernels on n random 26-letter ids, generated
+// (and timed) in batches so the whole set needn't be in memory at once.
+void benchmark_part1(size_t n) {
+    constexpr size_t batch{1 << 16};
+    std::mt19937 rng{2018};
+    std::uniform_int_distribution<int> letter{'a', 'z'};
+    box_ids ids(batch, box_id(26, 'a'));
+    double scalar_ms{0}, batched_ms{0};
+    long long checksum[2]{0, 0};
+
+    auto time{[](auto f) {
+        auto t1{std::chrono::high_resolution_clock::now()};
+        f();
+        auto t2{std::chrono::high_resolution_clock::now()};
+        return std::chrono::duration<double, std::milli>{t2 - t1}.count();
     }};
-    auto ids_with_exactly_n{[&](const int& n) {
-        return std::count_if(ids.cbegin(), ids.cend(), [&](const auto& id) {
-            return count_of_any_letter(id, n);
+    for (size_t done = 0; done < n; done += batch) {
+        ids.resize(std::min(batch, n - done));
+        for (auto& id : ids)
+            for (auto& c : id)
+                c = letter(rng);
+        const id_rows rows{ids};
+        scalar_ms += time([&] {
+            for (const auto& id : ids) {
+                auto [two, three]{letter_repeats(id)};
+                checksum[0] += two + 2 * three;
+            }
         });
-    }};
-    auto compute_checksum_from{[&](const auto& repeats_counts) {
-        return std::accumulate(repeats_counts.begin(), repeats_counts.end(), 1,
-                               [&](const int& product, const int& repeats) {
-                                   return product * ids_with_exactly_n(repeats);
-                               });
-    }};
-    return compute_checksum_from(letter_repeat_counts_to_match);
+        batched_ms += time([&] {
+            auto [twos, threes]{letter_repeats(rows, 0, rows.count)};
+            checksum[1] += twos + 2 * threes;
+        });
+    }
+    if (checksum[0] != checksum[1])
+        std::cerr << "Part 1 kernels disagree!\n", abort();
+    std::cout << "Part 1 on " << n << " ids:\n";
+    std::cout << "histogram: " << n / scalar_ms * 1e3 << " ids/sec\n";
+    std::cout << "batched:   " << n / batched_ms * 1e3 << " ids/sec\n";
 }
 
 /*****************************************************************************/
@@ -102,30 +237,169 @@ int part1(const box_ids& ids) {
 // (the boxes will have IDs which differ by exactly one character at the same
 // position in both strings)
 
+// Hamming distance of two id rows: one 32-byte compare & a popcount with
+// AVX2, else a byte loop (which the compiler vectorizes as best it can)
+inline int row_distance(const uint8_t* a, const uint8_t* b) {
+#if defined(__AVX2__)
+    __m256i ra{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a))};
+    __m256i rb{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b))};
+    return 32 - __builtin_popcount(
+                    unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(ra, rb))));
+#else
+    int distance{0};
+    for (size_t j = 0; j < id_rows::width; j++)
+        distance += a[j] != b[j];
+    return distance;
+#endif
+}
+
+// All pairs of (distinct, same length) ids within Hamming distance k, by
+// comparing every pair of rows: cache-blocked into tiles of row blocks (a
+// pair of blocks fits in L1), with threads taking the row blocks in turn.
+// With first_only, everyone stops at the first pair found.
+id_pairs near_pairs_pairwise(const id_rows& rows, int k, bool first_only) {
+    constexpr size_t block{256};  // rows per block: 8 KiB
+    const size_t blocks{(rows.count + block - 1) / block};
+    std::atomic<size_t> next_block{0};
+    std::atomic<bool> found{false};
+    std::mutex result_lock;
+    id_pairs pairs;
+
+    auto worker{[&] {
+        id_pairs mine;
+        for (size_t bi; !found && (bi = next_block++) < blocks;)
+            for (size_t bj = bi; bj < blocks && !found; bj++) {
+                size_t i_end{std::min(rows.count, (bi + 1) * block)};
+                size_t j_end{std::min(rows.count, (bj + 1) * block)};
+                for (size_t i = bi * block; i < i_end; i++)
+                    for (size_t j = bi == bj ? i + 1 : bj * block; j < j_end;
+                         j++) {
+                        int distance{row_distance(rows[i], rows[j])};
+                        if (distance > 0 && distance <= k &&
+                            rows.length[i] == rows.length[j]) {
+                            mine.emplace_back(i, j);
+                            if (first_only)
+                                found = true;
+                        }
+                    }
+            }
+        std::lock_guard<std::mutex> lock{result_lock};
+        pairs.insert(pairs.end(), mine.cbegin(), mine.cend());
+    }};
+
+    size_t threads{std::clamp<size_t>(std::thread::hardware_concurrency(), 1,
+                                      std::max<size_t>(blocks, 1))};
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; t++)
+        pool.emplace_back(worker);
+    worker();
+    for (auto& thread : pool)
+        thread.join();
+    std::sort(pairs.begin(), pairs.end());
+    if (first_only && pairs.size() > 1)
+        pairs.resize(1);
+    return pairs;
+}
+
 // Find the 2 box ids that differ by 1 character at the same position by
-// using the inner_product (ordered map/reduce) of id 2-combination pairs
-// (!=) not_eq map, (+) sum reduce
+// comparing all id 2-combination pairs (stops at the first one found), or
+// with the index for ids too long for the rows
 box_id part2(const box_ids& ids) {
-    box_id common_chars{"No solution"};  // solution memo
+    const id_rows rows{ids};
+    if (rows.truncated)
+        return part2_index(ids);
+    id_pairs pairs{near_pairs_pairwise(rows, 1, true)};
+    if (pairs.empty())
+        return "No solution";
+
+    // the common characters: id1 without the mismatch
+    box_id common_chars{ids[pairs[0].first]};
+    const box_id& id2{ids[pairs[0].second]};
+    auto [itr1, itr2] =
+        std::mismatch(common_chars.cbegin(), common_chars.cend(), id2.cbegin());
+    common_chars.erase(itr1);
+    return common_chars;
+}
+
+/*****************************************************************************/
+
+// All pairs of (distinct, same length) ids within Hamming distance k, with a
+// pigeonhole partitioned index: split the ids into k+1 segments, and 2 ids
+// with at most k mismatches must match exactly on at least one segment. So
+// per segment, sort the (segment hash, id) keys, pair up the ids with equal
+// hashes as candidates, and verify those on the full rows. A pair is only
+// reported for the first segment it matches on. Segments are processed in
+// parallel.
+id_pairs near_pairs_index(const id_rows& rows, int k) {
+    constexpr size_t W{id_rows::width};
+    if (k < 0 || size_t(k) + 1 > W)
+        return near_pairs_pairwise(rows, k, false);  // too short to split
+    const size_t n{rows.count}, segments{size_t(k) + 1};
+    size_t length{0};  // widest id
+    for (size_t i = 0; i < n; i++)
+        while (length < W && rows[i][length])
+            ++length;
+    length = std::max(length, segments);
+    auto bounds{[&](size_t s) {  // [begin, end) of segment s
+        return std::pair{s * length / segments, (s + 1) * length / segments};
+    }};
 
-    // for each id 2-combination (pair)...
-    for (auto id1 = ids.cbegin(); id1 < std::prev(ids.cend()); id1++)
-        for (auto id2 = std::next(id1); id2 < ids.cend(); id2++) {
-            // (+) reduce on (!=) map b/w each (id1[i], id2[i]) char pair
-            int diff_cnt =
-                std::inner_product(id1->cbegin(), id1->cend(), id2->cbegin(), 0,
-                                   std::plus<>{}, std::not_equal_to<>{});
-
-            // if only 1 character difference, done
-            if (diff_cnt == 1) {
-                common_chars = *id1;
-                auto [itr1, itr2] = std::mismatch(
-                    common_chars.cbegin(), common_chars.cend(), id2->cbegin());
-                common_chars.erase(itr1);
-                return common_chars;
+    std::atomic<size_t> next_segment{0};
+    std::mutex result_lock;
+    id_pairs pairs;
+    auto worker{[&] {
+        std::vector<std::pair<uint64_t, uint32_t>> keys(n);
+        id_pairs mine;
+        for (size_t s; (s = next_segment++) < segments;) {
+            auto [begin, end]{bounds(s)};
+            for (size_t i = 0; i < n; i++) {
+                uint64_t h{0xcbf29ce484222325};  // FNV-1a
+                for (size_t j = begin; j < end; j++)
+                    h = (h ^ rows[i][j]) * 0x100000001b3;
+                keys[i] = {h, uint32_t(i)};
+            }
+            std::sort(keys.begin(), keys.end());
+
+            // does the pair match exactly on an earlier segment?
+            auto seen_before{[&](const uint8_t* a, const uint8_t* b) {
+                for (size_t t = 0; t < s; t++) {
+                    auto [tb, te]{bounds(t)};
+                    if (std::equal(a + tb, a + te, b + tb))
+                        return true;
+                }
+                return false;
+            }};
+            for (size_t lo = 0, hi; lo < n; lo = hi) {
+                for (hi = lo + 1; hi < n && keys[hi].first == keys[lo].first;)
+                    ++hi;
+                for (size_t x = lo; x < hi; x++)
+                    for (size_t y = x + 1; y < hi; y++) {
+                        auto [a, b]{
+                            std::minmax(keys[x].second, keys[y].second)};
+                        int distance{row_distance(rows[a], rows[b])};
+                        if (distance > 0 && distance <= k &&
+                            rows.length[a] == rows.length[b] &&
+                            std::equal(rows[a] + begin, rows[a] + end,
+                                       rows[b] + begin) &&
+                            !seen_before(rows[a], rows[b]))
+                            mine.emplace_back(a, b);
+                    }
             }
         }
-    return common_chars;
+        std::lock_guard<std::mutex> lock{result_lock};
+        pairs.insert(pairs.end(), mine.cbegin(), mine.cend());
+    }};
+
+    size_t threads{std::clamp<size_t>(std::thread::hardware_concurrency(), 1,
+                                      segments)};
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; t++)
+        pool.emplace_back(worker);
+    worker();
+    for (auto& thread : pool)
+        thread.join();
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
 }
 
 /*****************************************************************************/
@@ -175,3 +449,136 @@ box_id part2_2(const box_ids& ids) {
 //             return sub;
 //     }
 // }
+
+/*****************************************************************************/
+
+// Part 2_3 (deletion-hash index, the production version of part 2_2)
+// The polynomial hash of an id with position i masked out is its prefix
+// hash (positions < i) plus its suffix hash (positions > i): that's the
+// whole id's hash minus position i's term, O(1) per position with no string
+// copies. Each position's (masked hash, full hash, id) keys are sorted to
+// find equal masked hashes, and hits are verified on the original ids (of
+// any length). Exact duplicate ids are only compared once. Positions are
+// processed in parallel; every buffer is allocated once, up front.
+box_id part2_index(const box_ids& ids) {
+    if (ids.size() < 2)
+        return "No solution";
+    const size_t n{ids.size()};
+    size_t positions{0};  // longest id
+    for (const auto& id : ids)
+        positions = std::max(positions, id.size());
+
+    // term j of an id's hash is (byte j) * base^j; the length is hashed in
+    // too (as a term past the last position), so only same length ids match
+    constexpr uint64_t base{0x100000001b3};
+    std::vector<uint64_t> power(positions + 1);
+    power[0] = 1;
+    for (size_t j = 1; j <= positions; j++)
+        power[j] = power[j - 1] * base;
+    auto byte{[&](size_t id, size_t j) { return uint8_t(ids[id][j]); }};
+    std::vector<uint64_t> full(n);
+    for (size_t id = 0; id < n; id++) {
+        for (size_t j = 0; j < ids[id].size(); j++)
+            full[id] += byte(id, j) * power[j];
+        full[id] += ids[id].size() * power[positions];
+    }
+
+    // do ids a & b differ in exactly position i?
+    auto verify{[&](size_t a, size_t b, size_t i) {
+        const box_id &ida{ids[a]}, &idb{ids[b]};
+        return ida.size() == idb.size() && ida[i] != idb[i] &&
+               std::equal(ida.cbegin(), ida.cbegin() + i, idb.cbegin()) &&
+               std::equal(ida.cbegin() + i + 1, ida.cend(),
+                          idb.cbegin() + i + 1);
+    }};
+
+    struct key {
+        uint64_t masked, full;
+        uint32_t id;
+        bool operator<(const key& o) const {
+            return std::tie(masked, full, id) <
+                   std::tie(o.masked, o.full, o.id);
+        }
+    };
+    std::atomic<size_t> next_position{0};
+    std::atomic<bool> found{false};
+    std::mutex result_lock;
+    box_id common_chars{"No solution"};  // solution memo
+    auto worker{[&] {
+        std::vector<key> keys;
+        std::vector<uint32_t> distinct;  // one id per distinct id in a run
+        keys.reserve(n);
+        for (size_t i; !found && (i = next_position++) < positions;) {
+            keys.clear();
+            for (size_t id = 0; id < n; id++)
+                if (i < ids[id].size())
+                    keys.push_back({full[id] - byte(id, i) * power[i],
+                                    full[id], uint32_t(id)});
+            std::sort(keys.begin(), keys.end());
+            for (size_t lo = 0, hi; lo < keys.size() && !found; lo = hi) {
+                distinct.clear();
+                for (hi = lo; hi < keys.size() && !found &&
+                              keys[hi].masked == keys[lo].masked;
+                     hi++) {
+                    const uint32_t id{keys[hi].id};
+                    if (hi > lo && keys[hi].full == keys[hi - 1].full &&
+                        ids[id] == ids[keys[hi - 1].id])
+                        continue;  // a duplicate of the previous id
+                    for (uint32_t other : distinct)
+                        if (verify(other, id, i)) {
+                            std::lock_guard<std::mutex> lock{result_lock};
+                            if (!found.exchange(true))
+                                common_chars = ids[id].substr(0, i) +
+                                               ids[id].substr(i + 1);
+                            break;
+                        }
+                    distinct.push_back(id);
+                }
+            }
+        }
+    }};
+
+    size_t threads{std::clamp<size_t>(std::thread::hardware_concurrency(), 1,
+                                      std::max<size_t>(positions, 1))};
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; t++)
+        pool.emplace_back(worker);
+    worker();
+    for (auto& thread : pool)
+        thread.join();
+    return common_chars;
+}
+
+// Time the part 2 index on n random 26-letter ids, with one planted pair of
+// ids differing in one position (the pairwise part 2 is hopeless at 10^6).
+void benchmark_part2(size_t n) {
+    std::mt19937 rng{2018};
+    std::uniform_int_distribution<int> letter{'a', 'z'};
+    box_ids ids(n, box_id(26, 'a'));
+    for (auto& id : ids)
+        for (auto& c : id)
+            c = letter(rng);
+    ids[n - 7] = ids[n / 3];
+    ids[n - 7][11] = ids[n / 3][11] == 'z' ? 'a' : ids[n / 3][11] + 1;
+    box_id expect{ids[n / 3]};
+    expect.erase(11, 1);
+
+    auto t1{std::chrono::high_resolution_clock::now()};
+    box_id common_chars{part2_index(ids)};
+    auto t2{std::chrono::high_resolution_clock::now()};
+    double ms{std::chrono::duration<double, std::milli>{t2 - t1}.count()};
+    if (common_chars != expect)
+        std::cerr << "Part 2 index missed the planted pair!\n", abort();
+    std::cout << "Part 2 on " << n << " ids: " << ms << "ms ("
+              << n / ms * 1e3 << " ids/sec)\n";
+
+    // and all pairs within distance 2 (just the planted one)
+    t1 = std::chrono::high_resolution_clock::now();
+    id_pairs pairs{near_pairs_index(id_rows{ids}, 2)};
+    t2 = std::chrono::high_resolution_clock::now();
+    ms = std::chrono::duration<double, std::milli>{t2 - t1}.count();
+    if (pairs != id_pairs{{n / 3, n - 7}})
+        std::cerr << "Near pair index missed the planted pair!\n", abort();
+    std::cout << "Pairs within distance 2 of " << n << " ids: " << ms
+              << "ms\n";
+}
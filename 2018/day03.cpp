@@ -3,10 +3,17 @@
 // https://adventofcode.com/2018/day/3
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <iostream>
 #include <iterator>
 #include <numeric>
+#include <set>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 // common code (to avoid duplicate code in each solution)
@@ -41,20 +48,99 @@ std::istream& operator>>(std::istream& is, Claim& c) {
 
 // type aliases for convenience and readability
 using Claims = std::vector<Claim>;
-using LocationToClaimCountMap = std::unordered_map<int, int>;
+using Counts = std::vector<int>;
 
 /*****************************************************************************/
 
-// the prototype fabric with the elf claims and a location-to-claim-count map
+// 2D sparse table: the max over any rectangle of a grid in O(1). Level
+// (ky, kx) holds, for every location where one fits, the max of the
+// 2^kx x 2^ky rectangle starting there (so it's (W - 2^kx + 1) wide); a query
+// rectangle is covered by 4 (overlapping) such rectangles of its rounded-down
+// power-of-two size. O(W H log W log H) space and build time, so values are
+// kept small (T = uint8_t).
+template <typename T>
+struct SparseTable2D {
+    int width{0}, height{0};
+    std::vector<std::vector<std::vector<T>>> levels;  // [ky][kx][y * w + x]
+
+    static int log2(int n) { return 31 - __builtin_clz(unsigned(n)); }
+
+    // bytes needed for a width x height grid
+    static long long bytes(int width, int height) {
+        long long cols{0}, rows{0};
+        for (int k = 0; width > 0 && k <= log2(width); k++)
+            cols += width - (1 << k) + 1;
+        for (int k = 0; height > 0 && k <= log2(height); k++)
+            rows += height - (1 << k) + 1;
+        return cols * rows * sizeof(T);
+    }
+
+    SparseTable2D() = default;
+    SparseTable2D(const std::vector<T>& grid, int width, int height)
+        : width(width), height(height) {
+        if (width <= 0 || height <= 0)
+            return;
+        levels.resize(log2(height) + 1);
+        for (int ky = 0; ky < int(levels.size()); ky++) {
+            levels[ky].resize(log2(width) + 1);
+            for (int kx = 0; kx < int(levels[ky].size()); kx++) {
+                std::vector<T>& level{levels[ky][kx]};
+                if (!ky && !kx) {
+                    level = grid;
+                    continue;
+                }
+                // combine 2 halves of the previous level, along x or y
+                const std::vector<T>& half{kx ? levels[ky][kx - 1]
+                                              : levels[ky - 1][kx]};
+                const int w{width - (1 << kx) + 1};
+                const int h{height - (1 << ky) + 1};
+                const int half_w{kx ? w + (1 << (kx - 1)) : w};
+                const int step{kx ? 1 << (kx - 1) : (1 << (ky - 1)) * w};
+                level.resize(size_t(w) * h);
+                for (int y = 0; y < h; y++)
+                    for (int x = 0, i = y * half_w; x < w; x++, i++)
+                        level[y * w + x] = std::max(half[i], half[i + step]);
+            }
+        }
+    }
+
+    // max over the w x h rectangle at (x, y) (must be non-empty & inside)
+    T max(int x, int y, int w, int h) const {
+        const int kx{log2(w)}, ky{log2(h)};
+        const std::vector<T>& level{levels[ky][kx]};
+        const int stride{width - (1 << kx) + 1};
+        const int x2{x + w - (1 << kx)}, y2{y + h - (1 << ky)};
+        return std::max({level[y * stride + x], level[y * stride + x2],
+                         level[y2 * stride + x], level[y2 * stride + x2]});
+    }
+};
+
+/*****************************************************************************/
+
+// the prototype fabric with the elf claims and a dense claim count grid
 struct Fabric {
     // all of the elves' claims
     Claims claims;
 
-    // efficiently maps fabric locations to the # of claims there
-    // Key: bitwise-or of (x,y) location
-    // Value: # of claims on (x,y)
-    // ((x<<15)|y) -> (# of claims on (x,y))
-    LocationToClaimCountMap claims_on_location;
+    // the claims' bounding box: the grid covers [x0, x0 + width) x
+    // [y0, y0 + height)
+    int x0{0}, y0{0}, width{0}, height{0};
+
+    // # of claims on each location (row-major over the bounding box)
+    Counts claims_on_location;
+
+    // 2D prefix sums of the overlapped locations (count >= 2): entry (x, y)
+    // is the # of them in [0, x) x [0, y), on a (width+1) x (height+1) grid
+    Counts overlaps_before;
+
+    // range max of the claim counts (saturated at 255), if built
+    SparseTable2D<uint8_t> max_claims;
+
+    // largest bounding box counted on a dense grid (else sweep the claims)
+    static constexpr long long max_dense_cells{1LL << 26};
+
+    // largest range max table built (else it's left empty)
+    static constexpr long long max_table_bytes{1LL << 27};
 
     // ctor
     Fabric(std::istream& is) {
@@ -62,18 +148,441 @@ struct Fabric {
         claim_the_fabric();
     };
 
-    // add 1 to a fabric location's claim count for each location in each claim
+    // Count the claims on every location: +1 at a claim's top left corner,
+    // -1 right of its top right & below its bottom left, +1 diagonally past
+    // its bottom right (a 2D difference array), then prefix sum along rows
+    // and columns. O(claims + width*height), no matter how big the claims.
     void claim_the_fabric() {
-        auto claim_fabric_area = [&](const Claim& claim) {
-            for (int row = claim.y; row < (claim.y + claim.h); row++)
-                for (int col = claim.x; col < (claim.x + claim.w); col++)
-                    ++claims_on_location[Fabric::loc2key(col, row)];
-        };
-        std::for_each(claims.cbegin(), claims.cend(), claim_fabric_area);
+        if (claims.empty())
+            return;
+        int x1{claims[0].x}, y1{claims[0].y};
+        x0 = claims[0].x, y0 = claims[0].y;
+        for (const Claim& c : claims) {
+            x0 = std::min(x0, c.x), y0 = std::min(y0, c.y);
+            x1 = std::max(x1, c.x + c.w), y1 = std::max(y1, c.y + c.h);
+        }
+        width = x1 - x0, height = y1 - y0;
+        if ((long long)(width + 1) * (height + 1) > max_dense_cells) {
+            width = height = 0;  // too big: left to the sweep line
+            return;
+        }
+
+        // the difference array has a spare column & row for the -1s
+        Counts diff((width + 1) * (height + 1), 0);
+        auto at{[&](int x, int y) -> int& {
+            return diff[y * (width + 1) + x];
+        }};
+        for (const Claim& c : claims) {
+            int x{c.x - x0}, y{c.y - y0};
+            ++at(x, y), --at(x + c.w, y);
+            --at(x, y + c.h), ++at(x + c.w, y + c.h);
+        }
+        claims_on_location.assign(width * height, 0);
+        for (int y = 0; y < height; y++)
+            for (int x = 0, row = 0; x < width; x++) {
+                row += at(x, y);
+                claims_on_location[y * width + x] =
+                    row + (y ? claims_on_location[(y - 1) * width + x] : 0);
+            }
+
+        overlaps_before.assign((width + 1) * (height + 1), 0);
+        for (int y = 0; y < height; y++)
+            for (int x = 0; x < width; x++)
+                overlaps_before[(y + 1) * (width + 1) + x + 1] =
+                    (claims_on_location[y * width + x] >= 2) +
+                    overlaps_before[y * (width + 1) + x + 1] +
+                    overlaps_before[(y + 1) * (width + 1) + x] -
+                    overlaps_before[y * (width + 1) + x];
+    };
+
+    // Build the range max table, on request: it's ~log W log H times the
+    // size of the grid, and overlaps_in() already answers "does this claim
+    // overlap" in O(1) from the prefix sums. Not built if over budget.
+    void build_max_claims() {
+        if (!dense() ||
+            SparseTable2D<uint8_t>::bytes(width, height) > max_table_bytes)
+            return;
+        std::vector<uint8_t> saturated(claims_on_location.size());
+        for (size_t i = 0; i < saturated.size(); i++)
+            saturated[i] = std::min(claims_on_location[i], 255);
+        max_claims = SparseTable2D<uint8_t>{saturated, width, height};
+    }
+
+    // most claims on any one location of a claim, O(1) (0 if empty)
+    int max_claims_in(const Claim& c) const {
+        if (c.w <= 0 || c.h <= 0)
+            return 0;
+        return max_claims.max(c.x - x0, c.y - y0, c.w, c.h);
+    }
+
+    // # of overlapped locations inside a claim, O(1)
+    int overlaps_in(const Claim& c) const {
+        int x{c.x - x0}, y{c.y - y0};
+        auto before{[&](int x, int y) {
+            return overlaps_before[y * (width + 1) + x];
+        }};
+        return before(x + c.w, y + c.h) - before(x, y + c.h) -
+               before(x + c.w, y) + before(x, y);
+    }
+
+    // is the fabric counted on the dense grid?
+    bool dense() const { return claims.empty() || !overlaps_before.empty(); }
+
+    // # of overlapped locations in the whole fabric
+    int overlaps() const {
+        return overlaps_before.empty() ? 0 : overlaps_before.back();
+    }
+
+    // Parallel backend: the overlap area & the safe claim ids. The fabric is
+    // cut into tiles of whole rows (~256 KiB of counters each), the claims
+    // are binned by the tiles they touch, and each thread rasterizes a tile
+    // at a time into a uint8 buffer of saturating counters (row runs of
+    // saturating adds, which vectorize). Then it counts the cells >= 2, and
+    // flags the binned claims over any of them.
+    std::pair<long long, std::vector<int>> overlaps_tiled(
+        unsigned threads = std::thread::hardware_concurrency()) const {
+        if (claims.empty())
+            return {0, {}};
+        long long bx0{claims[0].x}, by0{claims[0].y}, bx1{bx0}, by1{by0};
+        for (const Claim& c : claims) {
+            bx0 = std::min<long long>(bx0, c.x);
+            by0 = std::min<long long>(by0, c.y);
+            bx1 = std::max(bx1, (long long)c.x + c.w);
+            by1 = std::max(by1, (long long)c.y + c.h);
+        }
+        const long long cols{bx1 - bx0}, rows{by1 - by0};
+        const long long tile_rows{
+            std::max(1LL, (256 << 10) / std::max(cols, 1LL))};
+        const long long tiles{(rows + tile_rows - 1) / tile_rows};
+
+        std::vector<std::vector<int>> bins(tiles);
+        for (int i = 0; i < int(claims.size()); i++) {
+            const Claim& c{claims[i]};
+            if (c.w > 0 && c.h > 0)
+                for (long long t = (c.y - by0) / tile_rows;
+                     t <= (c.y + c.h - 1 - by0) / tile_rows; t++)
+                    bins[t].push_back(i);
+        }
+
+        std::atomic<long long> next_tile{0}, area{0};
+        std::vector<std::atomic<bool>> overlapped(claims.size());
+        auto worker{[&] {
+            std::vector<uint8_t> counts(tile_rows * cols);
+            for (long long t; (t = next_tile++) < tiles;) {
+                const long long top{by0 + t * tile_rows};
+                const long long bottom{std::min(top + tile_rows, by1)};
+                std::fill(counts.begin(), counts.end(), 0);
+                auto clip{[&](const Claim& c) {  // claim rows in this tile
+                    return std::pair{std::max<long long>(c.y, top),
+                                     std::min<long long>(c.y + c.h, bottom)};
+                }};
+                for (int i : bins[t]) {
+                    const Claim& c{claims[i]};
+                    auto [y_begin, y_end]{clip(c)};
+                    for (long long y = y_begin; y < y_end; y++) {
+                        uint8_t* run{&counts[(y - top) * cols + c.x - bx0]};
+                        for (int x = 0; x < c.w; x++)
+                            run[x] = std::min(run[x] + 1, 255);
+                    }
+                }
+                long long tile_area{0};
+                for (uint8_t count : counts)
+                    tile_area += count >= 2;
+                area += tile_area;
+                for (int i : bins[t]) {
+                    const Claim& c{claims[i]};
+                    auto [y_begin, y_end]{clip(c)};
+                    for (long long y = y_begin; y < y_end; y++) {
+                        const uint8_t* run{
+                            &counts[(y - top) * cols + c.x - bx0]};
+                        if (std::any_of(run, run + c.w,
+                                        [](uint8_t n) { return n >= 2; }))
+                            overlapped[i] = true;
+                    }
+                }
+            }
+        }};
+
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < std::max(threads, 1u); t++)
+            pool.emplace_back(worker);
+        worker();
+        for (auto& thread : pool)
+            thread.join();
+
+        std::vector<int> safe;
+        for (size_t i = 0; i < claims.size(); i++)
+            if (!overlapped[i])
+                safe.push_back(claims[i].id);
+        return {area, safe};
+    }
+
+    /*************************************************************************/
+    // Incremental API: claims added & removed one at a time (by id), with the
+    // overlap area and the non-overlapping claims kept current in time
+    // proportional to the claim's area. Independent of the snapshot above
+    // (which is of the claims the fabric was built with).
+
+    // a 64x64 tile of the live grid: per location, the # of claims on it and
+    // the sum of their ids (so a location's only claim is known: the sum).
+    // Tiles are created on demand and freed once no claim covers them.
+    static constexpr int tile_size{64};
+    struct Tile {
+        std::array<int, tile_size * tile_size> count{};
+        std::array<long long, tile_size * tile_size> id_sum{};
+        int claimed{0};  // sum of the counts (0: tile unused)
+    };
+
+    std::unordered_map<uint64_t, Tile> live_tiles;  // tiles by (x, y) tile #
+    std::unordered_map<int, Claim> live_claims;     // the live claims by id
+    std::unordered_map<int, int> live_overlapped;   // id -> # of overlapped
+                                                    // locations in the claim
+    std::set<int> live_safe;    // ids of the claims overlapping no other
+    long long live_area{0};     // # of overlapped locations
+
+    // Visit all of a claim's locations, a tile at a time: f(tile, i) for the
+    // location at index i of the tile. Tiles left unused are freed.
+    template <typename F>
+    void visit_live(const Claim& c, F f) {
+        auto tile_of{[](int v) { return v >= 0 ? v / tile_size
+                                               : (v + 1) / tile_size - 1; }};
+        for (int ty = tile_of(c.y); ty <= tile_of(c.y + c.h - 1); ty++)
+            for (int tx = tile_of(c.x); tx <= tile_of(c.x + c.w - 1); tx++) {
+                const uint64_t key{(uint64_t(uint32_t(tx)) << 32) |
+                                   uint32_t(ty)};
+                Tile& tile{live_tiles[key]};
+                int y_begin{std::max(c.y, ty * tile_size)};
+                int y_end{std::min(c.y + c.h, (ty + 1) * tile_size)};
+                int x_begin{std::max(c.x, tx * tile_size)};
+                int x_end{std::min(c.x + c.w, (tx + 1) * tile_size)};
+                for (int y = y_begin; y < y_end; y++)
+                    for (int x = x_begin; x < x_end; x++)
+                        f(tile, (y - ty * tile_size) * tile_size +
+                                    (x - tx * tile_size));
+                if (!tile.claimed)
+                    live_tiles.erase(key);
+            }
+    }
+
+    // a claim's # of overlapped locations changes by delta
+    void live_overlap(int id, int delta) {
+        int& overlapped{live_overlapped[id]};
+        if (overlapped == 0)
+            live_safe.erase(id);
+        overlapped += delta;
+        if (overlapped == 0)
+            live_safe.insert(id);
+    }
+
+    // add a claim (false if its id is already live): a location going from
+    // 1 to 2 claims becomes overlapped, for its previous claim too
+    bool add_claim(const Claim& c) {
+        if (!live_claims.emplace(c.id, c).second)
+            return false;
+        live_overlapped[c.id] = 0, live_safe.insert(c.id);
+        int overlapped{0};
+        visit_live(c, [&](Tile& tile, int i) {
+            if (tile.count[i] == 1)
+                live_overlap(int(tile.id_sum[i]), +1), ++live_area;
+            overlapped += tile.count[i] >= 1;
+            ++tile.count[i], tile.id_sum[i] += c.id, ++tile.claimed;
+        });
+        if (overlapped)
+            live_overlap(c.id, overlapped);
+        return true;
+    }
+
+    // remove a claim by id (false if not live): a location going from 2 to
+    // 1 claims is no longer overlapped, for its remaining claim too
+    bool remove_claim(int id) {
+        auto found{live_claims.find(id)};
+        if (found == live_claims.end())
+            return false;
+        visit_live(found->second, [&](Tile& tile, int i) {
+            --tile.count[i], tile.id_sum[i] -= id, --tile.claimed;
+            if (tile.count[i] == 1)
+                live_overlap(int(tile.id_sum[i]), -1), --live_area;
+        });
+        live_claims.erase(found);
+        live_overlapped.erase(id), live_safe.erase(id);
+        return true;
+    }
+};
+
+/*****************************************************************************/
+
+// Sweep-line engine for fabrics too large for a dense grid: claims become
+// x-events (a claim is active over [x, x + w)), swept in x order over a
+// segment tree on the compressed y coordinates (leaf i is the y-interval
+// [ys[i], ys[i + 1])). O(n log n) in the # of claims, whatever the size of
+// the fabric.
+struct SweepLine {
+    struct Event {
+        long long x;
+        int claim;   // index into the claims
+        bool start;  // claim starts (or ends) at x
+        // ends sort before starts at the same x (claims are half-open)
+        bool operator<(const Event& o) const {
+            return x != o.x ? x < o.x : start < o.start;
+        }
     };
 
-    // combines (x,y) claim locations into a single int key (x[31:16] | y[15:0])
-    static int loc2key(int x, int y) { return ((x << 15) bitor (y)); };
+    const Claims& claims;
+    std::vector<long long> ys;  // the distinct claim y-edges, sorted
+    std::vector<Event> events;  // the claim starts & ends, sorted
+    std::vector<std::pair<int, int>> leaves;  // claim y-intervals as [lo, hi)
+
+    SweepLine(const Claims& claims) : claims(claims) {
+        for (int i = 0; i < int(claims.size()); i++) {
+            const Claim& c{claims[i]};
+            if (c.w <= 0 || c.h <= 0)
+                continue;  // covers nothing
+            ys.push_back(c.y), ys.push_back((long long)c.y + c.h);
+            events.push_back({c.x, i, true});
+            events.push_back({(long long)c.x + c.w, i, false});
+        }
+        std::sort(ys.begin(), ys.end());
+        ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+        std::sort(events.begin(), events.end());
+
+        auto leaf{[&](long long y) {
+            return int(std::lower_bound(ys.cbegin(), ys.cend(), y) -
+                       ys.cbegin());
+        }};
+        for (const Claim& c : claims)
+            leaves.emplace_back(leaf(c.y), leaf((long long)c.y + c.h));
+    }
+
+    // Area covered by 2+ claims. Each tree node keeps how many claims cover
+    // all of it (never pushed down), and the length of its interval covered
+    // at least once & at least twice, counting the claims of its subtree
+    // plus those of its ancestors' covers.
+    long long overlap_area() const {
+        struct Node {
+            int cover{0};
+            long long once{0}, twice{0};
+        };
+        const int leafs{std::max(int(ys.size()) - 1, 1)};
+        std::vector<Node> tree(4 * leafs);
+        auto update{[&](auto& self, int node, int l, int r, int lo, int hi,
+                        int add) -> void {
+            Node& n{tree[node]};
+            if (lo <= l && r <= hi)
+                n.cover += add;
+            else {
+                int m{(l + r) / 2};
+                if (lo < m)
+                    self(self, 2 * node, l, m, lo, hi, add);
+                if (m < hi)
+                    self(self, 2 * node + 1, m, r, lo, hi, add);
+            }
+            long long once_below{0}, twice_below{0};
+            if (r - l > 1) {
+                const Node &left{tree[2 * node]}, &right{tree[2 * node + 1]};
+                once_below = left.once + right.once;
+                twice_below = left.twice + right.twice;
+            }
+            long long full{ys[r] - ys[l]};
+            n.once = n.cover >= 1 ? full : once_below;
+            n.twice = n.cover >= 2 ? full : n.cover == 1 ? once_below
+                                                         : twice_below;
+        }};
+
+        long long area{0}, x{events.empty() ? 0 : events[0].x};
+        for (const Event& e : events) {
+            area += tree[1].twice * (e.x - x), x = e.x;
+            auto [lo, hi]{leaves[e.claim]};
+            update(update, 1, 0, leafs, lo, hi, e.start ? 1 : -1);
+        }
+        return area;
+    }
+
+    // Claims overlapping no other. Of 2 overlapping claims, the one starting
+    // later finds the other still active in its y-range when it starts (the
+    // max active count there is > 0); the one starting first finds the
+    // later one's start stamped on its y-range when it ends (the max start
+    // stamp there is newer than its own). One tree does both range maxes.
+    std::vector<int> safe_claims() const {
+        // per node: max # of active claims below (incl. its own lazy add),
+        // and max start stamp below (plus a pending assignment: stamps only
+        // increase, so an assignment is the new max of everything below)
+        struct Node {
+            int active{0}, add{0}, stamp{-1}, assign{-1};
+        };
+        const int leafs{std::max(int(ys.size()) - 1, 1)};
+        std::vector<Node> tree(4 * leafs);
+        auto push{[&](int node) {
+            if (tree[node].assign >= 0)
+                for (int child : {2 * node, 2 * node + 1})
+                    tree[child].stamp = tree[child].assign = tree[node].assign;
+            tree[node].assign = -1;
+        }};
+        auto pull{[&](int node) {
+            const Node &left{tree[2 * node]}, &right{tree[2 * node + 1]};
+            tree[node].active =
+                tree[node].add + std::max(left.active, right.active);
+            tree[node].stamp = std::max(left.stamp, right.stamp);
+        }};
+
+        // a claim starts at stamp t: returns the max # of claims active in
+        // its range, then adds it & stamps the range with t
+        auto start{[&](auto& self, int node, int l, int r, int lo, int hi,
+                       int t) -> int {
+            Node& n{tree[node]};
+            if (lo <= l && r <= hi) {
+                int before{n.active};
+                ++n.add, ++n.active, n.stamp = n.assign = t;
+                return before;
+            }
+            push(node);
+            int m{(l + r) / 2}, before{0};
+            if (lo < m)
+                before = self(self, 2 * node, l, m, lo, hi, t);
+            if (m < hi)
+                before = std::max(before,
+                                  self(self, 2 * node + 1, m, r, lo, hi, t));
+            pull(node);
+            return n.add + before;
+        }};
+        // a claim ends: returns the latest start stamp in its range, then
+        // removes it
+        auto end{[&](auto& self, int node, int l, int r, int lo,
+                     int hi) -> int {
+            Node& n{tree[node]};
+            if (lo <= l && r <= hi) {
+                --n.add, --n.active;
+                return n.stamp;
+            }
+            push(node);
+            int m{(l + r) / 2}, latest{-1};
+            if (lo < m)
+                latest = self(self, 2 * node, l, m, lo, hi);
+            if (m < hi)
+                latest = std::max(latest,
+                                  self(self, 2 * node + 1, m, r, lo, hi));
+            pull(node);
+            return latest;
+        }};
+
+        std::vector<int> started(claims.size(), -1);
+        std::vector<bool> overlapped(claims.size(), false);
+        int t{0};
+        for (const Event& e : events) {
+            auto [lo, hi]{leaves[e.claim]};
+            if (e.start) {
+                started[e.claim] = t;
+                if (start(start, 1, 0, leafs, lo, hi, t++) > 0)
+                    overlapped[e.claim] = true;
+            } else if (end(end, 1, 0, leafs, lo, hi) > started[e.claim])
+                overlapped[e.claim] = true;
+        }
+
+        std::vector<int> ids;
+        for (size_t i = 0; i < claims.size(); i++)
+            if (!overlapped[i])
+                ids.push_back(claims[i].id);
+        return ids;
+    }
 };
 
 /*****************************************************************************/
@@ -83,10 +592,10 @@ struct Fabric {
 // Solution: 115304
 //
 // Count fabric locations with claim counts greater than or equal to 2
-int part1(const Fabric& fabric) {
-    auto gte_2 = [](const auto& loc_count) { return loc_count.second >= 2; };
-    return std::count_if(fabric.claims_on_location.cbegin(),
-                         fabric.claims_on_location.cend(), gte_2);
+long long part1(const Fabric& fabric) {
+    if (!fabric.dense())
+        return SweepLine{fabric.claims}.overlap_area();
+    return fabric.overlaps();
 }
 
 /*****************************************************************************/
@@ -95,24 +604,48 @@ int part1(const Fabric& fabric) {
 // What is the ID of the only claim that doesn't overlap?
 // Solution: 275
 //
-// Find the only claim whose fabric location counts are all equal to 1
+// Find the only claim whose fabric location counts are all equal to 1: with
+// no overlapped locations inside (an O(1) prefix sum query), or if the range
+// max table was built, whose max location count is 1 (an O(1) range max)
 int part2(const Fabric& fabric) {
+    if (!fabric.dense()) {
+        std::vector<int> safe{SweepLine{fabric.claims}.safe_claims()};
+        return safe.empty() ? -1 : safe.front();
+    }
     auto no_overlaps = [&](const Claim& claim) {
-        for (int row = claim.y; row < (claim.y + claim.h); row++)
-            for (int col = claim.x; col < (claim.x + claim.w); col++)
-                if (fabric.claims_on_location.at(Fabric::loc2key(col, row)) > 1)
-                    return false;
-        return true;
+        if (!fabric.max_claims.levels.empty())
+            return fabric.max_claims_in(claim) <= 1;
+        return fabric.overlaps_in(claim) == 0;
     };
     auto safe_claim =
         std::find_if(fabric.claims.cbegin(), fabric.claims.cend(), no_overlaps);
-    return safe_claim->id;
+    return safe_claim == fabric.claims.cend() ? -1 : safe_claim->id;
 }
 
 /*****************************************************************************/
 
-int main() {
+// (--tiled: solve with the parallel tiled backend, --live: by adding the
+// claims one at a time, --range-max: check claims with the range max table)
+int main(int argc, char* argv[]) {
     Fabric fabric(std::cin);
+    if (argc > 1 && std::string{argv[1]} == "--range-max")
+        fabric.build_max_claims();
+    if (argc > 1 && std::string{argv[1]} == "--tiled") {
+        auto [overlaps, safe]{fabric.overlaps_tiled()};
+        std::cout << "Part 1: Overlaps = " << overlaps << std::endl;
+        std::cout << "Part 2: Safe Id# = " << (safe.empty() ? -1 : safe[0])
+                  << std::endl;
+        return 0;
+    }
+    if (argc > 1 && std::string{argv[1]} == "--live") {
+        for (const Claim& claim : fabric.claims)
+            fabric.add_claim(claim);
+        std::cout << "Part 1: Overlaps = " << fabric.live_area << std::endl;
+        std::cout << "Part 2: Safe Id# = "
+                  << (fabric.live_safe.empty() ? -1 : *fabric.live_safe.begin())
+                  << std::endl;
+        return 0;
+    }
     std::cout << "Part 1: Overlaps = " << part1(fabric) << std::endl;  // 115304
     std::cout << "Part 2: Safe Id# = " << part2(fabric) << std::endl;  // 275
 }
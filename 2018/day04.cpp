@@ -4,112 +4,221 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
 #include <numeric>
-#include <regex>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 // type aliases for convenience and readability
-using minutes_array = std::array<int, 60>;
-using timecards = std::unordered_map<int, minutes_array>;
-using timestamps = std::vector<std::string>;
+using event_keys = std::vector<uint64_t>;
+
+// A guard event packed into 64 bits, so events sort as plain integers:
+// [63:31] timestamp (minutes since year 0, counting 31-day months, which
+// preserves the order: < 2^33 for any 4-digit year), [30:29] event type,
+// [28:0] guard id (shift starts; larger ids are rejected, not truncated)
+enum event_type : uint64_t { begins_shift, falls_asleep, wakes_up };
+constexpr int time_shift{31}, type_shift{29};
+constexpr uint64_t guard_mask{(uint64_t{1} << type_shift) - 1};
+
+// parse an event record with fixed offsets, e.g.
+// [1518-11-01 00:05] falls asleep / wakes up / Guard #10 begins shift
+// 0    5  8  11 14 17 19     26
+uint64_t parse_event(const std::string& line) {
+    auto number{[&](size_t at, size_t digits) {
+        uint64_t n{0};
+        for (size_t i = at; i < at + digits; i++)
+            n = n * 10 + (line[i] - '0');
+        return n;
+    }};
+    uint64_t year{number(1, 4)}, month{number(6, 2)}, day{number(9, 2)};
+    uint64_t hour{number(12, 2)}, minute{number(15, 2)};
+    uint64_t time{(((year * 12 + month) * 31 + day) * 24 + hour) * 60 + minute};
+
+    uint64_t type{line[19] == 'f'   ? falls_asleep
+                  : line[19] == 'w' ? wakes_up
+                                    : begins_shift};
+    uint64_t guard{0};
+    if (type == begins_shift)
+        for (size_t i = 26; i < line.size() && line[i] != ' '; i++)
+            if ((guard = guard * 10 + (line[i] - '0')) > guard_mask)
+                std::cerr << "Guard id too large: " << line << "\n", abort();
+    return time << time_shift | type << type_shift | guard;
+}
 
-// parse the dated event record input lines into a vector
-timestamps parse_lines(std::istream& is) {
-    timestamps guard_events;
+// parse the dated event record input lines into packed event keys
+event_keys parse_lines(std::istream& is) {
+    event_keys guard_events;
     for (std::string event; std::getline(is, event);)
-        guard_events.push_back(event);
+        if (event.size() > 19)
+            guard_events.push_back(parse_event(event));
     return guard_events;
 }
 
-// makes a "timecard" for each guard according to the recorded events
-timecards fillout_timecards(timestamps& guard_events) {
-    // timestamp regexes to match
-    std::smatch match;
-    static const std::regex re_guard(R"(.*Guard #(\d+) begins shift)");
-    static const std::regex re_falls(R"(.*:(\d+)\] falls asleep)");
-    static const std::regex re_wakes(R"(.*:(\d+)\] wakes up)");
+// LSD radix sort of the keys by their timestamp bits, a byte at a time
+// (stable, so same-time events keep their input order). Bytes that are the
+// same in all keys (e.g. the year's) are skipped.
+void radix_sort_by_time(event_keys& keys) {
+    event_keys buffer(keys.size());
+    for (int shift = time_shift; shift < 64; shift += 8) {
+        std::array<size_t, 257> offsets{};
+        for (uint64_t key : keys)
+            ++offsets[((key >> shift) & 0xff) + 1];
+        if (std::count(offsets.cbegin(), offsets.cend(), keys.size()))
+            continue;  // one bucket: nothing to do
+        std::partial_sum(offsets.cbegin(), offsets.cend(), offsets.begin());
+        for (uint64_t key : keys)
+            buffer[offsets[(key >> shift) & 0xff]++] = key;
+        keys.swap(buffer);
+    }
+}
 
-    timecards cards;            // maps guard ids to sleep counts per minute
-    int* minutes_00 = nullptr;  // ptr to a guard's sleep schedule array
-    int slept_at, wakes_at;     // the minutes field parsed from the timestamps
+// The guards' timecards as one dense guards x minutes table (a row per
+// guard, padded to 64 minutes so rows are whole vector registers), filled
+// via per-row difference arrays: a nap is +1 at its first minute and -1 at
+// its waking minute, and one prefix sum pass turns those into counts. Row
+// totals, sleepiest minutes & prefix sums are then computed once, in plain
+// loops over whole rows (which vectorize), so queries never rescan them.
+struct timecards {
+    static constexpr int minutes{60}, stride{64};
+
+    std::vector<int> guard_ids;           // row -> guard id
+    std::unordered_map<int, int> row_of;  // guard id -> row
+    std::vector<int32_t> asleep;          // # of times asleep on a minute
+    std::vector<int32_t> before;          // ... summed over minutes [0, m)
+    std::vector<int32_t> total;           // row -> minutes asleep
+    std::vector<int> sleepiest;           // row -> most slept minute
+
+    size_t guards() const { return guard_ids.size(); }
+
+    // the row of a guard (added if new)
+    int row(int guard_id) {
+        auto [it, added]{row_of.try_emplace(guard_id, int(guards()))};
+        if (added) {
+            guard_ids.push_back(guard_id);
+            asleep.resize(guards() * stride, 0);
+        }
+        return it->second;
+    }
+
+    // a guard naps from minute `from` until (not including) minute `to`
+    void nap(int r, int from, int to) {
+        ++asleep[r * stride + from], --asleep[r * stride + to];
+    }
+
+    // turn the difference arrays into counts, and precompute the rest
+    void finish() {
+        before.assign(guards() * stride, 0);
+        total.assign(guards(), 0);
+        sleepiest.assign(guards(), 0);
+        for (size_t r = 0; r < guards(); r++) {
+            int32_t* row{&asleep[r * stride]};
+            int32_t* sums{&before[r * stride]};
+            std::partial_sum(row, row + minutes, row);
+            row[minutes] = 0;
+            std::partial_sum(row, row + minutes, sums + 1);
+            total[r] = sums[minutes];
+            sleepiest[r] = std::max_element(row, row + minutes) - row;
+        }
+    }
+
+    // # of times a guard was asleep on a minute
+    int32_t count(int r, int minute) const {
+        return asleep[r * stride + minute];
+    }
+
+    // Query: the sleepiest minute of a guard and how often it's slept on
+    std::pair<int, int> sleepiest_minute(int guard_id) const {
+        int r{row_of.at(guard_id)};
+        return {sleepiest[r], count(r, sleepiest[r])};
+    }
+
+    // Query: the guard asleep the most minutes in the range [from, to) of
+    // the hour, and how many (O(1) per guard via the prefix sums)
+    std::pair<int, int> sleepiest_guard(int from = 0, int to = minutes) const {
+        int best{-1}, most{-1};
+        for (size_t r = 0; r < guards(); r++) {
+            int slept{before[r * stride + to] - before[r * stride + from]};
+            if (slept > most)
+                best = r, most = slept;
+        }
+        return {best < 0 ? -1 : guard_ids[best], most};
+    }
+
+    // Query: the guard most frequently asleep on one same minute, that
+    // minute, and how often
+    std::array<int, 3> most_frequent_sleeper() const {
+        int best{-1};
+        for (size_t r = 0; r < guards(); r++)
+            if (best < 0 || count(r, sleepiest[r]) >
+                                count(best, sleepiest[best]))
+                best = r;
+        if (best < 0)
+            return {-1, -1, 0};
+        return {guard_ids[best], sleepiest[best],
+                count(best, sleepiest[best])};
+    }
+};
 
-    // first sort the shift events in chronological order
-    std::sort(guard_events.begin(), guard_events.end());
-
-    // then parse the timestamps and compute each guard's sleep habits per min
-    auto increment_time_slept = [](int& slept) { slept++; };
-    for (const auto& event : guard_events)
-        if (std::regex_search(event, match, re_guard)) {
-            int guard_id = std::stoi(match[1]);
-            minutes_00 = cards[guard_id].data();
-        } else if (std::regex_search(event, match, re_wakes)) {
-            wakes_at = std::stoi(match[1]);
-            std::for_each(minutes_00 + slept_at, minutes_00 + wakes_at,
-                          increment_time_slept);
-        } else if (std::regex_search(event, match, re_falls))
-            slept_at = std::stoi(match[1]);
+// makes a "timecard" for each guard according to the recorded events
+timecards fillout_timecards(event_keys& guard_events) {
+    timecards cards;   // guards' sleep counts per minute
+    int guard{-1};     // the row of the guard on shift
+    int slept_at{0};   // the minute the guard fell asleep
 
+    // first sort the shift events in chronological order
+    radix_sort_by_time(guard_events);
+
+    // then replay the events to compute each guard's sleep habits per min
+    for (uint64_t event : guard_events) {
+        int minute = (event >> time_shift) % 60;
+        switch ((event >> type_shift) & 3) {
+            case begins_shift:
+                guard = cards.row(event & guard_mask);
+                break;
+            case falls_asleep:
+                slept_at = minute;
+                break;
+            case wakes_up:
+                if (guard >= 0 && slept_at < minute)
+                    cards.nap(guard, slept_at, minute);
+                break;
+        }
+    }
+    cards.finish();
     return cards;
 }
 
 // main
 int main() {
     // the timestamped guard shift events
-    timestamps guard_events{parse_lines(std::cin)};
+    event_keys guard_events{parse_lines(std::cin)};
 
-    // maps guard ids to their sleep amount per minute
-    timecards cards{fillout_timecards(guard_events)};
-
-    // returns the <index,count> of the minute with the max sleep time count
-    auto max_minute_asleep = [](const auto& min_arr) {
-        return [&](const auto&& minute_itr) -> std::pair<int, int> {
-            return {std::distance(min_arr.cbegin(), minute_itr), *minute_itr};
-        }(std::max_element(min_arr.cbegin(), min_arr.cend()));
-    };
+    // each guard's sleep amount per minute
+    const timecards cards{fillout_timecards(guard_events)};
 
     // Part 1
     // Strategy 1: Find the guard that has the most minutes asleep. What minute
     // does that guard spend asleep the most?
     // Solution: 30630 (Guard #1021 x Minute 30)
-
-    // compare the total time slept of all the guards (max sum of all minutes)
-    const auto& [guard_id1, guard_minutes1] = *std::max_element(
-        cards.cbegin(), cards.cend(), [](const auto& L, const auto& R) {
-            auto sum_time_slept = [](const auto& min_arr) {
-                return std::accumulate(min_arr.cbegin(), min_arr.cend(), 0);
-            };
-            const auto& [L_id, L_minutes] = L;
-            const auto& [R_id, R_minutes] = R;
-            return sum_time_slept(L_minutes) < sum_time_slept(R_minutes);
-        });
+    const auto [guard_id1, slept1]{cards.sleepiest_guard()};
+    const auto [max_minute1, cnt1]{cards.sleepiest_minute(guard_id1)};
 
     // Part 2
     // Strategy 2: Of all guards, which guard is most frequently asleep on the
     // same minute?
     // Solution: 136571 (Guard #3331 x Minute 41)
-
-    // compare the max sleep minute amount of all the guards (max of maxms)
-    const auto& [guard_id2, guard_minutes2] = *std::max_element(
-        cards.cbegin(), cards.cend(), [&](const auto& L, const auto& R) {
-            const auto& [L_id, L_minutes] = L;
-            const auto& [R_id, R_minutes] = R;
-            const auto&& [L_index, L_max_sleep] = max_minute_asleep(L_minutes);
-            const auto&& [R_index, R_max_sleep] = max_minute_asleep(R_minutes);
-            return L_max_sleep < R_max_sleep;
-        });
-
-    // retrieve the sleepiest minute for each of the sleepiest guards found
-    const auto& [max_minute1, cnt1] = max_minute_asleep(guard_minutes1);
-    const auto& [max_minute2, cnt2] = max_minute_asleep(guard_minutes2);
+    const auto [guard_id2, max_minute2, cnt2]{cards.most_frequent_sleeper()};
 
     // output the solutions
-    std::cout << "Part 1: " << max_minute1 * guard_id1 << "\t(Guard #"
-              << guard_id1 << " x Minute " << max_minute1 << ")\n";
+    std::cout << "Part 1: " << (long long)max_minute1 * guard_id1
+              << "\t(Guard #" << guard_id1 << " x Minute " << max_minute1
+              << ")\n";
 
-    std::cout << "Part 2: " << max_minute2 * guard_id2 << "\t(Guard #"
-              << guard_id2 << " x Minute " << max_minute2 << ")\n"
+    std::cout << "Part 2: " << (long long)max_minute2 * guard_id2
+              << "\t(Guard #" << guard_id2 << " x Minute " << max_minute2
+              << ")\n"
               << std::flush;
-}
\ No newline at end of file
+}
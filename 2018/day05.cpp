@@ -4,16 +4,137 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <iterator>
 #include <numeric>
 #include <string>
+#include <thread>
+#include <vector>
 
 // type aliases for convenience and readability
 using polymer = std::string;
 
-int main() {
+// Fully react [first, last) onto the end of a reacted polymer used as the
+// stack. Fast path: a block of units without a reacting neighbour pair (nor
+// with the stack top) can't change, so it's pushed whole; the pair test is
+// a byte-wise xor & compare over the block, which vectorizes. Otherwise the
+// block goes through the stack a unit at a time.
+void react_onto(polymer& stack, const char* first, const char* last) {
+    constexpr ptrdiff_t block{32};
+    size_t top{stack.size()};  // stack size
+    stack.resize(top + (last - first));
+    char* units{stack.data()};
+    while (first != last) {
+        const ptrdiff_t n{std::min(block, last - first)};
+        bool quiet{!top || (units[top - 1] ^ first[0]) != 32};
+        unsigned char pairs{0};
+        for (ptrdiff_t i = 0; i + 1 < n; i++)
+            pairs |= (first[i] ^ first[i + 1]) == 32;
+        if (quiet && !pairs)
+            std::copy(first, first + n, units + top), top += n;
+        else
+            for (const char* unit = first; unit != first + n; unit++)
+                if (top && (units[top - 1] ^ *unit) == 32)
+                    --top;
+                else
+                    units[top++] = *unit;
+        first += n;
+    }
+    stack.resize(top);
+}
+
+// Parallel reaction: reduction is associative (it's a free group's), so the
+// polymer is cut in chunks reacted independently on threads, then the
+// reacted chunks are joined left to right, reacting across each boundary
+// (just the units cancelling there: the rest takes the fast path).
+polymer react_parallel(const polymer& poly, unsigned threads) {
+    threads = std::max(threads, 1u);
+    const size_t chunks{threads * 4}, chunk{poly.size() / chunks + 1};
+    std::vector<polymer> reacted(chunks);
+    std::atomic<size_t> next_chunk{0};
+    auto worker = [&]() {
+        for (size_t c; (c = next_chunk++) < chunks;) {
+            size_t begin{std::min(poly.size(), c * chunk)};
+            size_t end{std::min(poly.size(), begin + chunk)};
+            react_onto(reacted[c], poly.data() + begin, poly.data() + end);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; t++)
+        pool.emplace_back(worker);
+    worker();
+    for (auto& thread : pool)
+        thread.join();
+
+    polymer result{std::move(reacted[0])};
+    for (size_t c = 1; c < chunks; c++) {
+        react_onto(result, reacted[c].data(),
+                   reacted[c].data() + reacted[c].size());
+        polymer{}.swap(reacted[c]);  // free it
+    }
+    return result;
+}
+
+// All 26 single unit type removals in one scan: 26 separate reaction stacks
+// (with a sentinel 0 at the bottom) and their depths, and the stack tops in
+// a 32-byte lane array (26 lanes used). Each unit is pushed or popped on
+// every stack but the one of its own type. The pop test of all the lanes is
+// one byte-wise xor & compare over the tops, which vectorizes; the stack
+// updates are branch-free per lane (the unit is always stored just above the
+// top, and only counts when pushed). The polymer is read once, not 26 times.
+std::array<size_t, 26> react_without_each(const polymer& poly) {
+    constexpr size_t lanes{32};
+    std::array<std::vector<char>, 26> stacks;
+    for (auto& stack : stacks)
+        stack.assign(poly.size() + 2, 0);
+    std::array<uint32_t, 26> depth{};
+    alignas(lanes) std::array<char, lanes> tops{};
+    for (const char unit : poly) {
+        alignas(lanes) std::array<uint8_t, lanes> pops;
+        for (size_t lane = 0; lane < lanes; lane++)
+            pops[lane] = (tops[lane] ^ unit) == 32;
+        const size_t removed = (unit | 0x20) - 'a';
+        for (size_t lane = 0; lane < stacks.size(); lane++) {
+            const uint32_t keep = lane != removed;
+            const uint32_t pop = keep & pops[lane], push = keep & !pop;
+            char* stack{stacks[lane].data()};
+            stack[depth[lane] + 1] = unit;
+            depth[lane] += push - pop;
+            tops[lane] = stack[depth[lane]];
+        }
+    }
+    std::array<size_t, 26> sizes;
+    std::copy(depth.cbegin(), depth.cend(), sizes.begin());
+    return sizes;
+}
+
+// main: solve both parts (--bench [MiB]: time the sequential & parallel
+// reactions on a generated polymer of that size instead, default 1 GiB;
+// --single-pass: part 2 with the single scan engine, cross-checked against
+// the thread pool)
+int main(int argc, char* argv[]) {
+    const unsigned threads = std::thread::hardware_concurrency();
+    const bool bench = argc > 1 && std::string{argv[1]} == "--bench";
     polymer the_polymer;
-    std::getline(std::cin, the_polymer);  // std::cin >> the_polymer;
+    if (bench) {
+        // random units, half of them undoing the previous one so there's
+        // plenty to react (xorshift: the generator is not the bottleneck)
+        size_t size = (argc > 2 ? std::stoull(argv[2]) : 1024) << 20;
+        the_polymer.resize(size);
+        uint64_t x = 88172645463325252ull;
+        for (size_t i = 0; i < size; i++) {
+            x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+            the_polymer[i] = i && (x & 1)
+                                 ? the_polymer[i - 1] ^ 32
+                                 : char((x >> 8) % 26 + ((x >> 16) & 1 ? 'a'
+                                                                       : 'A'));
+        }
+    } else
+        std::getline(std::cin, the_polymer);  // std::cin >> the_polymer;
 
     // Part 1
     // How many units remain after fully reacting the polymer you scanned?
@@ -35,7 +156,30 @@ int main() {
         poly.pop_back();  // restore the polymer back to its original state
         return size;
     };
-    size_t part1_size = react(the_polymer);
+    if (bench) {
+        auto time = [](auto f) {
+            auto t1{std::chrono::high_resolution_clock::now()};
+            size_t size = f();
+            auto t2{std::chrono::high_resolution_clock::now()};
+            std::chrono::duration<double, std::milli> ms{t2 - t1};
+            std::cout << size << " units left (" << ms.count() << "ms)\n";
+            return size;
+        };
+        std::cout << "Reacting " << the_polymer.size() << " units...\n";
+        std::cout << "Parallel (" << threads << " threads): ";
+        size_t parallel = time([&] {
+            return react_parallel(the_polymer, threads).size();
+        });
+        std::cout << "Sequential: ";
+        size_t sequential = time([&] { return react(the_polymer); });
+        if (parallel != sequential)
+            std::cerr << "Reactions disagree!\n", abort();
+        return 0;
+    }
+
+    // react in parallel chunks (same result as react(), minus the copy)
+    const polymer reacted = react_parallel(the_polymer, threads);
+    size_t part1_size = reacted.size();
 
     // Part 2
     // What is the length of the shortest polymer you can produce by removing
@@ -43,18 +187,43 @@ int main() {
     // Solution: 5124
 
     // Remove all units of exactly one type and react the result, once per unit
+    // Reaction commutes with removing a unit type, so start from the already
+    // reacted polymer (much shorter) instead of the original. The 26 removals
+    // run on a pool of threads, each reusing its own scratch polymer.
     static char units[26];                               // lowercase alphabet
     std::iota(std::begin(units), std::end(units), 'a');  // a-z
 
-    // for (char unit = 'a'; unit <= 'z'; unit++) {
-    size_t part2_size = SIZE_MAX;
-    for (const char& unit : units) {
-        polymer poly = the_polymer;  // work on a copy since we mutate
-        auto eq_un = [&](const char& c) { return unit == tolower(c); };
-        // char zip[2] = {unit, char(toupper(unit))};  // e.g. {a,A}
-        // for (char& cC : zip)
-        poly.erase(std::remove_if(poly.begin(), poly.end(), eq_un), poly.end());
-        part2_size = std::min(part2_size, react(poly));
+    std::array<size_t, 26> sizes;   // reacted size, per unit removed
+    std::atomic<size_t> next_unit{0};
+    auto worker = [&]() {
+        polymer poly;  // scratch
+        poly.reserve(reacted.size() + 1);
+        for (size_t u; (u = next_unit++) < sizes.size();) {
+            const char unit = units[u];
+            auto ne_un = [&](const char& c) { return unit != (c | 0x20); };
+            poly.clear();
+            std::copy_if(reacted.cbegin(), reacted.cend(),
+                         std::back_inserter(poly), ne_un);
+            sizes[u] = react(poly);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < std::clamp(threads, 1u, 26u); t++)
+        pool.emplace_back(worker);
+    worker();
+    for (auto& thread : pool)
+        thread.join();
+    size_t part2_size = *std::min_element(sizes.cbegin(), sizes.cend());
+
+    if (argc > 1 && std::string{argv[1]} == "--single-pass") {
+        auto t1{std::chrono::high_resolution_clock::now()};
+        const std::array<size_t, 26> single = react_without_each(reacted);
+        auto t2{std::chrono::high_resolution_clock::now()};
+        std::chrono::duration<double, std::milli> ms{t2 - t1};
+        std::cerr << "Single pass: " << ms.count() << "ms\n";
+        if (single != sizes)
+            std::cerr << "Single pass removals disagree!\n", abort();
+        part2_size = *std::min_element(single.cbegin(), single.cend());
     }
 
     // output the solutions
@@ -7,94 +7,132 @@
 #include <chrono>
 #include <iostream>
 #include <numeric>
-#include <unordered_set>
+#include <utility>
 #include <vector>
+
+// bit-packed cellular automaton engine
+#include "automaton.hpp"
+// cycle detection & fast-forwarding
+#include "cycle.hpp"
 using namespace std;
 
 // Global constants.
 const int initSize = 100;
 const int ruleSize = 5;
+const int margin = 64;  // empty pots kept either side of the plants
 const char potChar = '.';
 const char plantChar = '#';
 
+// The pots: one row of 1-bit cells. Pot # loc is cell # (loc + offset).
+typedef Automaton<1> Pots;
+
 // Parse the input: Initial plant locations & evolution ruleset.
-void parseInput(unordered_set<int>& plants,
-                unordered_set<unsigned long>& rules) {
+void parseInput(Pots& plants, long offset, vector<bool>& rules) {
     // Parse the initial plant locations state into a bitset.
     string line;
     getline(cin, line);
     bitset<initSize> initialState(line, 15, 15 + initSize, potChar, plantChar);
 
-    // Build set of plant locations from initial state.
+    // Set the initial plant locations.
     for (int loc = 0; loc < initSize; loc++)
         if (initialState[initSize - loc - 1])  // bitset indices are reversed
-            plants.insert(loc);
+            plants.set(0, 0, loc + offset);
 
     getline(cin, line);  // skip empty line
 
-    // Parse the ruleset. Only keep rules that produce a new plant.
+    // Parse the ruleset into a lookup table: rule bitset (as an int) -> plant?
     while (getline(cin, line)) {
         bitset<ruleSize> rule(line.substr(0, ruleSize), 0, ruleSize, potChar,
                               plantChar);
-        if (line[line.length() - 1] == plantChar)  // only keep birthing rules
-            rules.insert(rule.to_ulong());
+        rules[rule.to_ulong()] = (line[line.length() - 1] == plantChar);
     }
 }
 
+// Sum of the pot numbers that contain a plant.
+long sumPlants(const Pots& plants, long offset) {
+    long sum = 0;
+    plants.forEach(0, [&](size_t, size_t cell) { sum += long(cell) - offset; });
+    return sum;
+}
+
+// The cells of the leftmost & rightmost plants ({cols, 0} if none).
+pair<size_t, size_t> plantSpan(const Pots& plants) {
+    pair<size_t, size_t> span{plants.cols, 0};
+    plants.forEach(0, [&](size_t, size_t cell) {
+        span = {min(span.first, cell), cell};
+    });
+    return span;
+}
+
+// The plants spread & drift: once they come within ruleSize pots of either
+// end of the row, copy them to the middle of a (wide enough) new row.
+void recenter(Pots& plants, long& offset) {
+    auto [first, last]{plantSpan(plants)};
+    if (first > last || (first >= ruleSize && last + ruleSize < plants.cols))
+        return;
+    size_t cols{max(plants.cols, 2 * (last - first + 1) + 2 * margin)};
+    size_t start{(cols - (last - first + 1)) / 2};
+    Pots wider{1, cols};
+    plants.forEach(0, [&](size_t, size_t cell) {
+        wider.set(0, 0, cell - first + start);
+    });
+    offset += long(start) - long(first);
+    plants = move(wider);
+}
+
+// Hash of the plant pattern, regardless of where it is: the plants' pot
+// numbers relative to the leftmost one, packed into words. And its position.
+pair<Hash128, int64_t> patternKey(const Pots& plants, long offset) {
+    auto [first, last]{plantSpan(plants)};
+    if (first > last)
+        return {Hash128{}, 0};
+    vector<uint64_t> pattern((last - first) / 64 + 1);
+    plants.forEach(0, [&](size_t, size_t cell) {
+        pattern[(cell - first) / 64] |= uint64_t{1} << ((cell - first) % 64);
+    });
+    return {Hash128{}.add(pattern.begin(), pattern.end()),
+            int64_t(first) - offset};
+}
+
 // Cellular automaton of plants.
 void solve() {
-    // Set of plant locations and the evolution ruleset.
-    unordered_set<int> plants;           // key is plant location
-    unordered_set<int> newPlants;        // for the next generation
-    unordered_set<unsigned long> rules;  // key is rule bitset as an int
-    parseInput(plants, rules);
-
-    long sum = 0, prevSum;        // for detecting growth stability
-    long gen20Sum, gen50Sum;      // memo part1, part2 answers
-    const int generations = 100;  // iteration maximum
-
-    // Evolve the plant cellular automata.
-    for (int gen = 1; gen <= generations; gen++) {
-        // Find the plant location bounds.
-        auto [minLoc, maxLoc] = minmax_element(plants.begin(), plants.end());
-
-        // Debug: Draw the plants.
-        bitset<initSize> draw;
-        for (int loc = *minLoc; loc < initSize - *minLoc; loc++)
-            draw[loc - *minLoc] = plants.count(loc);
-        cerr << draw.to_string('.', '#');
-
-        // Apply the evolution rules.
-        newPlants.clear();        // clear previous generation
-        bitset<ruleSize> region;  // to inspect plant locations for rule matches
-        for (int loc = *minLoc - ruleSize; loc <= *maxLoc + ruleSize; loc++) {
-            region <<= 1;
-            region[0] = plants.count(loc);
-            if (rules.count(region.to_ulong()))
-                newPlants.insert(loc - (ruleSize / 2));
-        }
-        plants = newPlants;  // copy new generation
-
-        // Part 1
-        // After 20 generations, what is the sum of the numbers of
-        // all pots which contain a plant?
-        // Your puzzle answer was 2911
-        if (gen == 20)
-            gen20Sum = accumulate(plants.begin(), plants.end(), 0);
-
-        // Debug: After 90 generations, the plant growth is constant = 50.
-        prevSum = sum;
-        sum = accumulate(plants.begin(), plants.end(), 0);
-        cerr << "[Gen_" << gen << "] Size: " << plants.size() << " Sum: " << sum
-             << " Delta: " << sum - prevSum << endl;
-    }
+    // Pot # loc is cell # (loc + offset), the row is re-centred as needed.
+    long offset = margin;
+    Pots plants{1, size_t(initSize + 2 * margin)};
+    vector<bool> rules(1 << ruleSize);  // the evolution ruleset
+    parseInput(plants, offset, rules);
+
+    // Apply the evolution rules to 64 pots at once. Rule bit 4 is the pot 2 to
+    // the left, bit 0 the pot 2 to the right (the lookup table's index bits).
+    auto evolve{[&](const Pots::Window& pots) {
+        return Pots::Words{Pots::lookup<ruleSize>(
+            rules, {pots.at(0, 0, 2), pots.at(0, 0, 1), pots.at(0, 0, 0),
+                    pots.at(0, 0, -1), pots.at(0, 0, -2)})};
+    }};
+    auto step{[&] {
+        recenter(plants, offset);
+        plants.step(evolve);
+    }};
+
+    // Part 1
+    // After 20 generations, what is the sum of the numbers of
+    // all pots which contain a plant?
+    // Your puzzle answer was 2911
+    for (int gen = 1; gen <= 20; gen++)
+        step();
+    long gen20Sum = sumPlants(plants, offset);
 
     // Part 2
     // After fifty billion (50'000'000'000) generations, what is the sum of the
     // numbers of all pots which contain a plant?
     // Your puzzle answer was 2500000000695
-    gen50Sum = accumulate(plants.begin(), plants.end(), 0);
-    gen50Sum += (50'000'000'000 - generations) * (sum - prevSum);
+    // The plants settle into a pattern that repeats shifted (a glider): detect
+    // it with a translation invariant hash, then skip the remaining cycles,
+    // each moving every plant by the cycle's drift.
+    int64_t drift = fastForward(20, 50'000'000'000, step,
+                                [&] { return patternKey(plants, offset); });
+    long gen50Sum = sumPlants(plants, offset) + long(plants.count(0)) * drift;
+    cerr << "Size: " << plants.count(0) << " Drift: " << drift << endl;
 
     // Output the solutions.
     cout << "[Part 1]  = " << gen20Sum << endl;  // 2911
@@ -4,14 +4,15 @@
 
 #include <algorithm>
 #include <chrono>
-#include <cstring>
 #include <iostream>
 #include <iterator>
 #include <numeric>
-#include <queue>
 #include <thread>
 #include <utility>
 #include <vector>
+
+// grid & breadth-first search helpers
+#include "search.hpp"
 using namespace std;
 
 typedef pair<int, int> pii;
@@ -34,7 +35,6 @@ struct Unit {
 };
 
 // GLOBAL CONSTANTS ////////////////////////////////////
-queue<pii> Q;        // queue for bfs
 vector<Unit> units;  // the elves/goblins
 
 // The cave map data.
@@ -43,86 +43,55 @@ size_t rows{cave.size()};
 size_t cols{cave[0].size()};
 
 // Pathfinding data structures.
-const int MAXN{32};
-int DST[MAXN][MAXN];          // distance memos
-bool VST[MAXN][MAXN];         // visited? for bfs
-const int dx[]{0, 1, 0, -1};  // x/col adjacency
-const int dy[]{-1, 0, 1, 0};  // y/row adjacency
+Grid grid{rows, cols};           // cave location <-> flat index (reading order)
+Search fromUnit{rows * cols};    // distances from the unit taking its turn
+Search fromTarget{rows * cols};  // distances from the square it moves to
+const int dx[]{0, 1, 0, -1};     // x/col adjacency
+const int dy[]{-1, 0, 1, 0};     // y/row adjacency
 ////////////////////////////////////////////////////////
 
-// BFS Path Reconstruction.
-void reconstruct_path(pii cur, pii prev, pii goal, vector<pii>& result) {
-    if (cur == goal) {
-        result.push_back(prev);
-        return;
-    }
-    int dist = DST[cur.first][cur.second];
-    for (size_t d = 0; d < 4; d++) {  // check all adjacent locations
-        pii ncur = make_pair(cur.first + dy[d], cur.second + dx[d]);
-        if (ncur.first >= 0 && ncur.first < int(rows) && ncur.second >= 0 &&
-            ncur.second < int(cols) && DST[ncur.first][ncur.second] == dist - 1)
-            reconstruct_path(ncur, cur, goal, result);
-    }
-    return;
-}
+// Visit the open cave locations adjacent to a location (in reading order).
+const auto openNeighbors{[](size_t loc, auto visit) {
+    grid.neighbors(loc, [&](size_t nloc) {
+        if (cave[nloc / cols][nloc % cols] == '.')
+            visit(nloc);
+    });
+}};
 
 // BFS: Breadth First Search of the open cave locations.
 // Returns a location adjacent to the weakest, nearest enemy (in reading order).
 pii BFS(Unit& unit) {
-    memset(DST, 0x3f3f3f, sizeof(DST));  // prepare for BFS
-    memset(VST, 0, sizeof(VST));         // prepare for BFS
-
-    // BFS: Breadth First Search the entire cave, record distances in DST.
-    Q.push(make_pair(unit.y, unit.x));
-    DST[unit.y][unit.x] = 0;
-    while (!Q.empty()) {
-        pii cur = Q.front();
-        Q.pop();
-        if (VST[cur.first][cur.second])
-            continue;
-        VST[cur.first][cur.second] = true;
-        for (size_t d = 0; d < 4; d++) {  // check all adjacent locations
-            pii ncur = make_pair(cur.first + dy[d], cur.second + dx[d]);
-            if (ncur.first >= 0 && ncur.first < int(rows) && ncur.second >= 0 &&
-                ncur.second < int(cols) &&
-                cave[ncur.first][ncur.second] == '.' &&
-                !VST[ncur.first][ncur.second]) {
-                DST[ncur.first][ncur.second] = DST[cur.first][cur.second] + 1;
-                Q.push(ncur);
-            }
-        }
-    }
+    // BFS: Breadth First Search the entire cave, record distances.
+    fromUnit.bfs(grid.index(unit.y, unit.x), openNeighbors);
 
     // Find the shortest distance to the next closest enemy (in reading order).
-    int minDst = 4 * MAXN;
-    pii target = make_pair(MAXN, MAXN);
+    Search::Dist minDst{Search::Unreached};
+    size_t target{grid.size()};
     for (Unit& u : units) {
         if (u.type == unit.type)  // skip allies
             continue;
-        for (size_t d = 0; d < 4; d++) {  // check all adjacent locations
-            pii cur = make_pair(u.y + dy[d], u.x + dx[d]);
-            if (cur.first >= 0 && cur.first < int(rows) && cur.second >= 0 &&
-                cur.second < int(cols) && VST[cur.first][cur.second]) {
-                if (DST[cur.first][cur.second] < minDst) {
-                    minDst = DST[cur.first][cur.second];
-                    target = cur;
-                } else if (DST[cur.first][cur.second] == minDst && cur < target)
-                    target = cur;  // tie, select first in reading order
-            }
-        }
+        grid.neighbors(grid.index(u.y, u.x), [&](size_t loc) {
+            // ties: select first in reading order
+            if (fromUnit.reached(loc) &&
+                make_pair(fromUnit[loc], loc) < make_pair(minDst, target))
+                minDst = fromUnit[loc], target = loc;
+        });
     }
 
     // If the Unit cannot reach (find an open path to) any of the squares that
     // are in range, it ends its turn. Return an invalid location to inform.
-    if (minDst == 4 * MAXN)
+    if (minDst == Search::Unreached)
         return pii{-1, -1};
 
-    // Success. Return the location adjacent to the nearest enemy.
-    vector<pii> minPath;
-    reconstruct_path(target, make_pair(-1, -1), make_pair(unit.y, unit.x),
-                     minPath);
-    std::sort(minPath.begin(), minPath.end());
-    return minPath[0];
+    // Success. Return the location adjacent to the unit that starts a shortest
+    // path to the target (first in reading order): BFS back from the target.
+    fromTarget.bfs(target, openNeighbors);
+    size_t step{grid.size()};
+    grid.neighbors(grid.index(unit.y, unit.x), [&](size_t loc) {
+        if (step == grid.size() && fromTarget[loc] == minDst - 1)
+            step = loc;
+    });
+    return make_pair(step / cols, step % cols);
 }
 
 // Return pointer to weakest,closest adjacent enemy to attack, if it exists.
@@ -248,7 +217,7 @@ void solve() {
                 if (battleOver)
                     break;
 
-                drawCave();
+                // drawCave();
                 takeTurn(unit);  // move and attack if possible
 
                 // Remove dead units from the list & cave. Check if an elf died.
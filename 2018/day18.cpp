@@ -8,77 +8,63 @@
 #include <istream>
 #include <iterator>
 #include <thread>
-#include <unordered_map>
-#include <unordered_set>
 #include <vector>
-using namespace std;
-
-typedef unordered_map<uint16_t, uint8_t> umap;
-
-// Coordinates: helper struct
-struct coord {
-    uint8_t x, y;  // coords
-    uint16_t key;  // hash key
 
-    // Constructor
-    coord(uint8_t x, uint8_t y) : x(x), y(y) { keyify(); };
-
-    // Computes the key: Two 8-bit ints packed into one 16-bit int
-    void keyify() { key = (x << 8) | y; }
+// bit-packed cellular automaton engine
+#include "automaton.hpp"
+// cycle detection & fast-forwarding
+#include "cycle.hpp"
+using namespace std;
 
-    // Displacement helpers
-    coord dx(int8_t d) { return {uint8_t(x + d), y}; }
-    coord dy(int8_t d) { return {x, uint8_t(y + d)}; }
-};
+// The lumberyard cells as 2 bit planes: trees & lumberyards (neither = open)
+typedef Automaton<2> Acres;
+enum Plane { Trees, Lumbs };
 
 // The Lumberyard: Simulates the lumberyard growth patterns
 struct Yard {
     const uint8_t open = '.';  // cell types
     const uint8_t tree = '|';
     const uint8_t lumb = '#';
-    umap grid, grid2;  // hash map of coords to cell type
+    Acres grid{0, 0};  // the acres, 64 per word
     size_t rows;       // yard size: 50 rows
     size_t cols;       // yard size: 50 cols
 
-    // Count neighbours of a given grid cell coordinate
-    int cntNbor(coord co, uint8_t type) {
-        int cnt = 0;
-        for (int8_t dy = -1; dy <= 1; dy++) {
-            for (int8_t dx = -1; dx <= 1; dx++) {
-                coord nbor{co.dx(dx).dy(dy)};
-                if (grid[nbor.key] == type)
-                    cnt++;
-            }
-        }
-        return cnt;
+    // The growth rules, applied to 64 acres at once (bit-sliced neighbour
+    // counts: the 8 neighbours' bits are added up into 4-bit numbers)
+    static Acres::Words grow(const Acres::Window& acres) {
+        array<Acres::Word, 8> trees, lumbs;
+        for (int dy = -1, n = 0; dy <= 1; dy++)
+            for (int dx = -1; dx <= 1; dx++)
+                if (dy || dx) {
+                    trees[n] = acres.at(Trees, dy, dx);
+                    lumbs[n++] = acres.at(Lumbs, dy, dx);
+                }
+        auto treeCnt{Acres::sum(trees)}, lumbCnt{Acres::sum(lumbs)};
+        Acres::Word isTree{acres.at(Trees, 0, 0)};
+        Acres::Word isLumb{acres.at(Lumbs, 0, 0)};
+        Acres::Word isOpen{~isTree & ~isLumb};
+        Acres::Word treeNbr3{Acres::atLeast(treeCnt, 3)};
+        Acres::Word lumbNbr3{Acres::atLeast(lumbCnt, 3)};
+        Acres::Word stayLumb{Acres::atLeast(lumbCnt, 1) &
+                             Acres::atLeast(treeCnt, 1)};
+
+        // open -> tree (3+ trees), tree -> lumb (3+ lumbs),
+        // lumb -> open (unless 1+ lumbs and 1+ trees)
+        return {(isOpen & treeNbr3) | (isTree & ~lumbNbr3),
+                (isTree & lumbNbr3) | (isLumb & stayLumb)};
     }
 
     // Simulates one tick of lumberyard growth
-    void simulate() {
-        grid2 = grid;  // copy for double-buffering
-        for (uint8_t y = 1; y < rows; y++)
-            for (uint8_t x = 1; x < cols; x++) {
-                coord cur{x, y};
-                uint8_t cell = grid[cur.key];
-
-                // The growth rules
-                if (cell == open && cntNbor(cur, tree) >= 3)
-                    grid2[cur.key] = tree;
-                else if (cell == tree && cntNbor(cur, lumb) >= 3)
-                    grid2[cur.key] = lumb;
-                else if (cell == lumb)
-                    if (!(cntNbor(cur, lumb) > 1 && cntNbor(cur, tree) > 0))
-                        grid2[cur.key] = open;
-            }
-        swap(grid, grid2);  // swap to new grid
-    }
+    void simulate() { grid.step(grow); }
 
     // Debug draw the lumberyard
     void draw() {
         string ascii{string(rows, '\n')};  // clear screen
-        for (uint8_t y = 1; y < rows; y++) {
-            for (uint8_t x = 1; x < cols; x++)
-                ascii += grid[coord{x, y}.key];
+        for (size_t y = 0; y < rows; y++) {
+            for (size_t x = 0; x < cols; x++)
+                ascii += grid.get(Trees, y, x)   ? tree
+                         : grid.get(Lumbs, y, x) ? lumb
+                                                 : open;
             ascii += '\n';
         }
         cerr << ascii;
@@ -87,21 +73,35 @@ struct Yard {
 
     // Count all the cells of some type
     int countType(uint8_t type) const {
-        return count_if(grid.begin(), grid.end(),
-                        [&](auto& e) { return e.second == type; });
+        size_t trees{grid.count(Trees)}, lumbs{grid.count(Lumbs)};
+        if (type == tree)
+            return trees;
+        if (type == lumb)
+            return lumbs;
+        return rows * cols - trees - lumbs;
+    }
+
+    // Total resource value: # of trees x # of lumberyards
+    uint32_t resources() const { return countType(tree) * countType(lumb); }
+
+    // Hash of the whole yard (both bit planes), for cycle detection
+    Hash128 hash() const {
+        Hash128 h;
+        for (const auto& plane : grid.cells)
+            h.add(plane.begin(), plane.end());
+        return h;
     }
 
     // Parse the lumberyard data
     friend std::istream& operator>>(std::istream& is, Yard& Y) {
-        uint8_t x = 1, y = 1;  // margins @ top & left (prevent negatives)
-        for (string line; getline(cin, line);) {
-            x = 1;
-            for (uint8_t c : line)
-                Y.grid.emplace(coord{x++, y}.key, c);
-            y++;
-        }
-        // Compute rows/cols
-        Y.rows = y, Y.cols = x;
+        vector<string> lines{istream_iterator<string>{is}, {}};
+        Y.rows = lines.size(), Y.cols = lines[0].size();
+        Y.grid = Acres{Y.rows, Y.cols};
+        for (size_t y = 0; y < Y.rows; y++)
+            for (size_t x = 0; x < Y.cols; x++) {
+                Y.grid.set(Trees, y, x, lines[y][x] == Y.tree);
+                Y.grid.set(Lumbs, y, x, lines[y][x] == Y.lumb);
+            }
         cerr << "Yard Size: " << Y.rows << "x" << Y.cols << endl;
         return is;
     }
@@ -109,57 +109,22 @@ struct Yard {
 
 // Cellular automaton simulation.
 void solve() {
-    uint32_t part1{0}, part2{0};      // solution memos
-    uint32_t treeCnt{0}, lumbCnt{0};  // resource counts
-
-    // Cycle detection variables
-    unordered_map<uint32_t, uint32_t> yardHashCnt;
-    size_t cycleStart{0}, billion{1000000000};
-    uint32_t thresh{4}, target{0};
+    uint32_t part1{0}, part2{0};  // solution memos
+    const uint64_t billion{1000000000};
 
     // Simulate the lumberyard growth
     Yard yard;
     cin >> yard;
-    for (size_t curTime = 1; curTime <= billion; curTime++) {
+    for (int curTime = 1; curTime <= 10; curTime++)
         yard.simulate();
-        // yard.draw();
-        // this_thread::sleep_for(100ms);
-
-        // Count the resources at this timestep
-        treeCnt = yard.countType(yard.tree);
-        lumbCnt = yard.countType(yard.lumb);
-
-        // Use the resource counts as a hash/checksum to detect cycles
-        uint32_t resProd = treeCnt * lumbCnt;      // resources product (hash)
-        uint32_t rptCnt = ++yardHashCnt[resProd];  // how many times it occured
-
-        // Look for repeating resource products after a reasonable threshold cnt
-        if (rptCnt >= thresh && !target)
-            target = resProd, cycleStart = curTime;
-
-        // cerr << "Time: " << curTime << " Prod: " << resProd
-        //      << " Reps: " << rptCnt << endl;
-
-        // Look for the repeating resource product hash value again
-        if ((target == resProd) && (curTime > cycleStart)) {
-            size_t period = (curTime - cycleStart);
-            size_t deltaTime = (billion - cycleStart) % period;
-            cycleStart = billion;           // prevent entering this block again
-            billion = curTime + deltaTime;  // timestep to stop at (~1000000000)
-
-            cerr << "Period: " << period << endl;
-            cerr << "Time: " << curTime << endl;
-            cerr << "Delta: " << deltaTime << endl;
-            cerr << "Stop: " << billion << endl;
-        }
-
-        // At 10 iterations, we have the part 1 solution
-        if (curTime == 10)
-            part1 = resProd;
-
-        // At a time equivalent to a "billion", we have the part 2 solution
-        part2 = resProd;
-    }
+    // yard.draw();
+    part1 = yard.resources();
+
+    // The yard settles into a cycle (of 28 ticks): detect it by the hash of
+    // the full yard state, then skip whole cycles up to the billionth tick.
+    fastForward(10, billion, [&] { yard.simulate(); },
+                [&] { return pair{yard.hash(), int64_t{0}}; });
+    part2 = yard.resources();
 
     // Part 1: What will the total resource value of the lumber collection area
     // be after 10 minutes/iterations?
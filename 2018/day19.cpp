@@ -10,89 +10,17 @@
 #include <iterator>
 #include <numeric>
 #include <vector>
-using namespace std;
-
-// Define the device to simulate as per the given specs.
-struct Device {
-    typedef array<uintmax_t, 6> Registers;    //  [0, 1, 2, 3, 4, 5]
-    typedef array<uintmax_t, 4> Instruction;  //  [OP, Ain, Bin, Cout]
-    typedef void (*Op)(Registers&, size_t, size_t, size_t);  // fn pointer
-
-    Registers regs;  // set of 6 regs in the device
-
-    // opcode template: register vs. immediate "specialization" via bool flags
-    template <typename F, bool RegA = true, bool RegB = true>
-    static void OPR(Registers& regs, size_t A, size_t B, size_t C) {
-        F function;  // the operation to execute
-        regs[C] = function(RegA ? regs[A] : A, RegB ? regs[B] : B);  // execute
-    }
-
-    // the opcode definitions
-    constexpr static array<Op, 16> Opcodes = {{
-        OPR<plus<size_t>, true, true>,         // addr
-        OPR<plus<size_t>, true, false>,        // addi
-        OPR<multiplies<size_t>, true, true>,   // mulr
-        OPR<multiplies<size_t>, true, false>,  // muli
-        OPR<bit_and<size_t>, true, true>,      // banr
-        OPR<bit_and<size_t>, true, false>,     // bani
-        OPR<bit_or<size_t>, true, true>,       // borr
-        OPR<bit_or<size_t>, true, false>,      // bori
-        OPR<greater<size_t>, false, true>,     // gtir
-        OPR<greater<size_t>, true, false>,     // gtri
-        OPR<greater<size_t>, true, true>,      // gtrr
-        OPR<equal_to<size_t>, false, true>,    // eqir
-        OPR<equal_to<size_t>, true, false>,    // eqri
-        OPR<equal_to<size_t>, true, true>,     // eqrr
-
-        // setr: lambda (constexpr -> void)
-        [](Registers& regs, size_t A, size_t, size_t C) { regs[C] = regs[A]; },
-
-        // seti: lambda (constexpr -> void)
-        [](Registers& regs, size_t A, size_t, size_t C) { regs[C] = A; },
-
-    }};  // end Opcodes
-};       // end Device struct
 
-// Convert instruction string names to integer opcodes
-size_t opNameToOpcode(const string& opName) {
-    vector<string> opNames({"addr", "addi", "mulr", "muli", "banr", "bani",
-                            "borr", "bori", "gtir", "gtri", "gtrr", "eqir",
-                            "eqri", "eqrr", "setr", "seti"});
-
-    auto opIndex(find(opNames.begin(), opNames.end(), opName));
-    return distance(opNames.begin(), opIndex);
-}
-
-// Output a register set's full state
-ostream& operator<<(ostream& os, const Device::Registers& regs) {
-    for (auto& state : regs)
-        os << state << " ";
-    return os;
-}
-
-// Parse the input program instruction set
-istream& operator>>(istream& is, vector<Device::Instruction>& v) {
-    while (is.good()) {
-        Device::Instruction instr;
-        string opName;
-        cin >> opName;
-        instr[0] = opNameToOpcode(opName);
-        for (auto i = 1; i < 4; i++) {
-            uintmax_t n;
-            cin >> n;
-            instr[i] = n;
-        }
-        v.push_back(instr);
-    }
-    return is;
-}
+// ElfCode device, program parser & superinstruction fusion
+#include "elfcode.hpp"
+using namespace std;
 
 // Disassemble the program: sum of divisors of register 3
 // (O(n^2) process: too long too run for part 2
 void solve() {
     vector<Device::Instruction> instrs;  // input instruction set to execute
     Device::Registers regs{0};           // the register set
-    Device::Instruction instr;           // the current instruction
+    vector<Fusion::Line> code;           // the compiled (fused) program
     size_t ipReg;                        // instruction pointer register #
 
     // #ip 0        <- instruction pointer value register #
@@ -101,6 +29,11 @@ void solve() {
     string skip;
     cin >> skip >> ipReg >> instrs;
     size_t programSize = instrs.size();
+    // Optimize for regs[0] = 0 or 1. Observed: regs[0] (the part 1 answer)
+    // and regs[2], read after the ip > 32 break below for the divisor sum.
+    Optimizer::Value reg0{Optimizer::Value::Bool, 0};
+    code = Fusion::compile(Optimizer::optimize(instrs, ipReg, {0, 2}, reg0),
+                           ipReg);
     uintmax_t reg0at0{0};  // part 1 memo
     uintmax_t reg0at1{0};  // part 2 memo
 
@@ -112,9 +45,9 @@ void solve() {
             // state before execution
             // cerr << "ip=" << regs[ipReg] << " [" << regs << "] " << endl;
 
-            // execute the next instuction (indexed by ip register value)
-            instr = instrs[regs[ipReg]];
-            Device::Opcodes[instr[0]](regs, instr[1], instr[2], instr[3]);
+            // execute the next instuction(s) (indexed by ip register value)
+            const Fusion::Line& line = code[regs[ipReg]];
+            line.handler(regs, ipReg, line.first, line.second);
 
             // part 2: sum of divisors of 10551282 (register 3 @ ip=33)
             if (part == 2 && regs[ipReg] > 32)
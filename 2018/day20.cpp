@@ -6,20 +6,19 @@
 #include <array>
 #include <chrono>
 #include <iostream>
-#include <map>
-#include <queue>
-#include <set>
 #include <vector>
+
+// grid & breadth-first search helpers
+#include "search.hpp"
 using namespace std;
 
-typedef pair<int, int> Room;        // coordinates (x,y)
-map<Room, vector<Room>> RoomGraph;  // adjacency list
+typedef pair<int, int> Room;         // coordinates (x,y)
+vector<pair<Room, Room>> RoomDoors;  // edge list (doors go both ways)
 
-// Update room adjaceny lists and move to the new room
+// Record the door between the rooms and move to the new room
 void connectRoomsAndMoveToNewRoom(Room& atRoom, const Room& newRoom) {
-    RoomGraph[atRoom].push_back(newRoom);  // (atRoom) -> (newRoom)
-    RoomGraph[newRoom].push_back(atRoom);  // (newRoom) -> (atRoom)
-    atRoom = newRoom;                      // move to the new room
+    RoomDoors.push_back({atRoom, newRoom});  // (atRoom) <-> (newRoom)
+    atRoom = newRoom;                        // move to the new room
 }
 
 // Recursively parses the directions to build the rooms graph
@@ -59,30 +58,48 @@ void parseBuildGraph(string_view directions, size_t& dirIdx, Room atRoom) {
 // Breadth-first search the rooms graph after parsing the directions
 typedef pair<uintmax_t, uintmax_t> lengthPair;
 lengthPair bfs(string_view directions, uintmax_t lengthLimit = 0) {
-    RoomGraph.clear();  // multiple runs; global variable
+    RoomDoors.clear();  // multiple runs; global variable
 
     uintmax_t maxPathLength{0};  // part 1
     uintmax_t atLeastLength{0};  // part 2
 
     size_t dirIdx{1};                             // skip ^ char
-    parseBuildGraph(directions, dirIdx, {0, 0});  // build adj list
-
-    // bfs the rooms graph (edge adjaceny list)
-    set<Room> visited;
-    typedef pair<Room, uintmax_t> RoomPathLengths;
-    queue<RoomPathLengths> Q;
-    Q.push({{0, 0}, 0});  // starting location
-    while (!Q.empty()) {
-        auto [roomNode, pathLength] = Q.front();
-        Q.pop();
-        if (visited.count(roomNode))
-            continue;
+    parseBuildGraph(directions, dirIdx, {0, 0});  // build edge list
+
+    // lay the rooms out on a grid: each room keeps a bitmask of its doors
+    int minX{0}, maxX{0}, minY{0}, maxY{0};
+    for (auto& [from, to] : RoomDoors)
+        for (auto& [x, y] : {from, to}) {
+            minX = min(minX, x), maxX = max(maxX, x);
+            minY = min(minY, y), maxY = max(maxY, y);
+        }
+    Grid grid{size_t(maxY - minY + 1), size_t(maxX - minX + 1)};
+    auto roomIdx{[&](const Room& r) {
+        return grid.index(r.second - minY, r.first - minX);
+    }};
+    auto doorBit{[](size_t from, size_t to) {  // up, left, right, down
+        return (to < from) ? (from - to == 1 ? 2 : 1)
+                           : (to - from == 1 ? 4 : 8);
+    }};
+    vector<uint8_t> doors(grid.size(), 0);  // door bits of each room
+    for (auto& [from, to] : RoomDoors) {
+        size_t a{roomIdx(from)}, b{roomIdx(to)};
+        doors[a] |= doorBit(a, b), doors[b] |= doorBit(b, a);
+    }
+
+    // bfs the rooms grid through the doors
+    Search search{grid.size()};
+    search.bfs(roomIdx({0, 0}), [&](size_t room, auto visit) {
+        grid.neighbors(room, [&](size_t next) {
+            if (doors[room] & doorBit(room, next))
+                visit(next);
+        });
+    });
+    for (size_t room : search.queue) {  // every reached room
+        uintmax_t pathLength{search[room]};
         if (pathLength >= lengthLimit)
             ++atLeastLength;
-        visited.insert(roomNode);
         maxPathLength = max(pathLength, maxPathLength);
-        for (auto roomEdge : RoomGraph[roomNode])
-            Q.push({roomEdge, pathLength + 1});
     }
     return {maxPathLength, atLeastLength};
 }
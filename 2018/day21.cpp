@@ -7,94 +7,227 @@
 #include <chrono>
 #include <iostream>
 #include <iterator>
+#include <numeric>
 #include <set>
+#include <string>
 #include <unordered_set>
 #include <vector>
-using namespace std;
 
-// Define the device to simulate as per the given specs.
-struct Device {
-    typedef array<uintmax_t, 6> Registers;    //  [0, 1, 2, 3, 4, 5]
-    typedef array<uintmax_t, 4> Instruction;  //  [OP, Ain, Bin, Cout]
-    typedef void (*Op)(Registers&, size_t, size_t, size_t);  // fn pointer
+// ElfCode device, program parser & superinstruction fusion
+#include "elfcode.hpp"
+// cycle detection
+#include "cycle.hpp"
+using namespace std;
 
-    Registers regs;  // set of 6 registers in the device
+// Batch device: runs the same program in lockstep over N register files.
+// Registers are stored lane-wise (regs[r][lane]) so each opcode is a single
+// straight loop over the lanes, which the compiler turns into vector ops
+// (4 x 64-bit lanes per AVX2 register). Each step executes the instruction at
+// the lowest live ip; lanes at another ip, halted, or out of steps are masked.
+template <size_t N = 4>
+struct BatchDevice {
+    typedef array<uintmax_t, N> Lanes;  //  one value per lane
+    typedef array<Lanes, 6> Registers;  //  [0, 1, 2, 3, 4, 5] x lanes
+    typedef array<uintmax_t, N> Mask;   //  ~0 = lane executes, 0 = idle
+    typedef void (*Op)(Registers&, const Mask&, size_t, size_t, size_t);
 
-    // opcode template: register vs. immediate "specialization" via bool flags
+    // opcode template: same flags as Device::OPR, applied under a lane mask
     template <typename F, bool RegA = true, bool RegB = true>
-    static void OPR(Registers& regs, size_t A, size_t B, size_t C) {
+    static void OPR(Registers& regs, const Mask& mask, size_t A, size_t B,
+                    size_t C) {
         F function;  // the operation to execute
-        regs[C] = function(RegA ? regs[A] : A, RegB ? regs[B] : B);  // execute
+        for (size_t l = 0; l < N; ++l) {
+            uintmax_t r{function(RegA ? regs[A][l] : A, RegB ? regs[B][l] : B)};
+            regs[C][l] = (r & mask[l]) | (regs[C][l] & ~mask[l]);  // blend
+        }
     }
 
-    // the opcode definitions
-    constexpr static array<Op, 16> Opcodes = {{
-        OPR<plus<size_t>, true, true>,         // addr
-        OPR<plus<size_t>, true, false>,        // addi
-        OPR<multiplies<size_t>, true, true>,   // mulr
-        OPR<multiplies<size_t>, true, false>,  // muli
-        OPR<bit_and<size_t>, true, true>,      // banr
-        OPR<bit_and<size_t>, true, false>,     // bani
-        OPR<bit_or<size_t>, true, true>,       // borr
-        OPR<bit_or<size_t>, true, false>,      // bori
-        OPR<greater<size_t>, false, true>,     // gtir
-        OPR<greater<size_t>, true, false>,     // gtri
-        OPR<greater<size_t>, true, true>,      // gtrr
-        OPR<equal_to<size_t>, false, true>,    // eqir
-        OPR<equal_to<size_t>, true, false>,    // eqri
-        OPR<equal_to<size_t>, true, true>,     // eqrr
-
-        // setr: lambda (constexpr -> void)
-        [](Registers& regs, size_t A, size_t, size_t C) { regs[C] = regs[A]; },
-
-        // seti: lambda (constexpr -> void)
-        [](Registers& regs, size_t A, size_t, size_t C) { regs[C] = A; },
+    // setr/seti: pass the A operand through
+    struct first {
+        uintmax_t operator()(uintmax_t a, uintmax_t) const { return a; }
+    };
 
+    // the opcode definitions (same order as Device::Opcodes)
+    constexpr static array<Op, 16> Opcodes = {{
+        OPR<plus<uintmax_t>, true, true>,         // addr
+        OPR<plus<uintmax_t>, true, false>,        // addi
+        OPR<multiplies<uintmax_t>, true, true>,   // mulr
+        OPR<multiplies<uintmax_t>, true, false>,  // muli
+        OPR<bit_and<uintmax_t>, true, true>,      // banr
+        OPR<bit_and<uintmax_t>, true, false>,     // bani
+        OPR<bit_or<uintmax_t>, true, true>,       // borr
+        OPR<bit_or<uintmax_t>, true, false>,      // bori
+        OPR<greater<uintmax_t>, false, true>,     // gtir
+        OPR<greater<uintmax_t>, true, false>,     // gtri
+        OPR<greater<uintmax_t>, true, true>,      // gtrr
+        OPR<equal_to<uintmax_t>, false, true>,    // eqir
+        OPR<equal_to<uintmax_t>, true, false>,    // eqri
+        OPR<equal_to<uintmax_t>, true, true>,     // eqrr
+        OPR<first, true, false>,                  // setr
+        OPR<first, false, false>,                 // seti
     }};  // end Opcodes
-};       // end Device struct
-
-// Convert instruction string names to integer opcodes
-size_t opNameToOpcode(const string& opName) {
-    vector<string> opNames({"addr", "addi", "mulr", "muli", "banr", "bani",
-                            "borr", "bori", "gtir", "gtri", "gtrr", "eqir",
-                            "eqri", "eqrr", "setr", "seti"});
-    auto opIndex(find(opNames.begin(), opNames.end(), opName));
-    return distance(opNames.begin(), opIndex);
-}
 
-// Output a register set's full state
-ostream& operator<<(ostream& os, const Device::Registers& regs) {
-    for (uintmax_t const& state : regs)
-        os << state << " ";
-    return os;
-}
+    // Run the program with regs[0] = reg0[lane] in each lane (all other
+    // registers zero). Returns the # of instructions each lane executed before
+    // halting, or maxSteps for lanes that did not halt within the budget.
+    static Lanes run(const vector<Device::Instruction>& instrs, size_t ipReg,
+                     const Lanes& reg0, uintmax_t maxSteps) {
+        Registers regs{};
+        Lanes steps{};
+        regs[0] = reg0;
+        for (;;) {
+            // the lowest ip among the live lanes is executed next
+            uintmax_t ip{instrs.size()};
+            for (size_t l = 0; l < N; ++l)
+                if (regs[ipReg][l] < instrs.size() && steps[l] < maxSteps)
+                    ip = min(ip, regs[ipReg][l]);
+            if (ip == instrs.size())
+                break;  // every lane halted or ran out of steps
+
+            Mask mask;
+            for (size_t l = 0; l < N; ++l)
+                mask[l] = (regs[ipReg][l] == ip && steps[l] < maxSteps)
+                              ? ~uintmax_t{0}
+                              : 0;
+
+            const Device::Instruction& instr = instrs[ip];
+            Opcodes[instr[0]](regs, mask, instr[1], instr[2], instr[3]);
 
-// Parse the input program instruction set
-// #ip 2        <- instruction pointer value register #
-// seti 123 0 3 <- the instr/opcode executed [OP, Ain, Bin, Cout]
-// ...
-istream& operator>>(istream& is, vector<Device::Instruction>& v) {
-    while (is.good()) {
-        Device::Instruction instr;
-        string opName;
-        cin >> opName;
-        instr[0] = opNameToOpcode(opName);
-        for (auto i = 1; i < 4; i++) {
-            uintmax_t n;
-            cin >> n;
-            instr[i] = n;
+            // increase instruction pointer & step count of executing lanes
+            for (size_t l = 0; l < N; ++l) {
+                regs[ipReg][l] += mask[l] & 1;
+                steps[l] += mask[l] & 1;
+            }
         }
-        v.push_back(instr);
+        return steps;
+    }
+};  // end BatchDevice struct
+
+// The halt value sequence: the values eqrr compares regs[0] against, in the
+// order the program produces them. If nothing the program computed is still
+// live after eqrr except the tested register (and regs[0] is never written,
+// nor read but by eqrr), each halt value is a function of the previous one
+// only: next(h) runs the optimized program from eqrr back to eqrr, with its
+// counting loops replaced by their closed form, so it costs a few dozen
+// native instructions instead of ~10^5 interpreted ones.
+struct HaltSequence {
+    size_t ipReg, eqrrLine, testReg;  // ip register, eqrr line & register
+    vector<Fusion::Line> code;        // the optimized & fused program
+    vector<CountingLoop> loops;       // its counting loops
+    vector<size_t> loopAt;            // loop index by head line (or npos)
+
+    // Analyze the program. False if next() isn't a function of h alone.
+    bool extract(const vector<Device::Instruction>& instrs) {
+        Optimizer::Program opt{Optimizer::optimize(instrs, ipReg, {testReg})};
+        for (size_t ip = 0; ip < opt.size(); ++ip) {
+            const Optimizer::Form& f{Optimizer::Forms[opt[ip][0]]};
+            if (opt[ip][3] == 0)
+                return false;  // regs[0] is written
+            if (ip != eqrrLine &&
+                ((f.regA && opt[ip][1] == 0) ||
+                 (f.regB && f.kind != Optimizer::Set && opt[ip][2] == 0)))
+                return false;  // regs[0] is read (next() fakes its value)
+        }
+
+        // live registers after eqrr (its own result only picks the branch)
+        vector<Optimizer::State> in;
+        Optimizer::Graph succs;
+        if (!Optimizer::propagate(opt, ipReg, {Optimizer::Value::Any, 0}, in,
+                                  succs))
+            return false;
+        auto live{Optimizer::liveness(opt, ipReg, succs, {})[eqrrLine]};
+        for (size_t r = 0; r < live.size(); ++r)
+            if (live[r] && r != 0 && r != ipReg && r != testReg &&
+                r != opt[eqrrLine][3])
+                return false;
+
+        // stop only at line boundaries at eqrr & the loop heads
+        loops = CountingLoop::find(opt, ipReg);
+        loopAt.assign(opt.size(), string::npos);
+        set<size_t> barriers{eqrrLine, eqrrLine - 1};
+        for (size_t i = 0; i < loops.size(); ++i)
+            loopAt[loops[i].head] = i, barriers.insert(loops[i].head - 1);
+        code = Fusion::compile(opt, ipReg, barriers);
+        return true;
+    }
+
+    // Run until the ip is back at eqrr (or the program halts), adding the #
+    // of instructions executed to steps.
+    uintmax_t run(Device::Registers& regs, uintmax_t& steps) const {
+        do {
+            size_t ip{regs[ipReg]};
+            if (loopAt[ip] < loops.size()) {
+                steps += loops[loopAt[ip]].run(regs, ipReg);
+                continue;
+            }
+            const Fusion::Line& line = code[ip];
+            line.handler(regs, ipReg, line.first, line.second);
+            steps += line.length;
+            ++regs[ipReg];
+        } while (regs[ipReg] < code.size() && regs[ipReg] != eqrrLine);
+        return regs[testReg];
+    }
+
+    // the first halt value (from the start of the program)
+    uintmax_t first(uintmax_t& steps) const {
+        Device::Registers regs{0};
+        return run(regs, steps);
+    }
+    uintmax_t first() const {
+        uintmax_t steps{0};
+        return first(steps);
+    }
+
+    // the halt value after h (regs[0] != h, so the program doesn't halt)
+    uintmax_t next(uintmax_t h, uintmax_t& steps) const {
+        Device::Registers regs{0};
+        regs[0] = h + 1;
+        regs[testReg] = h;
+        regs[ipReg] = eqrrLine;
+        return run(regs, steps);
+    }
+    uintmax_t next(uintmax_t h) const {
+        uintmax_t steps{0};
+        return next(h, steps);
+    }
+
+    // # of instructions from eqrr to the end when regs[0] == h
+    uintmax_t haltSteps(uintmax_t h) const {
+        Device::Registers regs{0};
+        uintmax_t steps{0};
+        regs[0] = regs[testReg] = h;
+        regs[ipReg] = eqrrLine;
+        run(regs, steps);
+        return steps;
+    }
+};  // end HaltSequence struct
+
+// Exact instruction-count oracle: the # of instructions the program executes
+// before it halts, for regs[0] = each of the first n halt values. The counts
+// are accumulated while stepping through the halt sequence (counting loops
+// add their trip count formula), so no trace is stored and no value is run
+// from scratch. (They assume regs[0] only matters at eqrr: the batch device
+// checks that on a sample.)
+vector<uintmax_t> haltCounts(const HaltSequence& seq, size_t n,
+                             bool verbose = false) {
+    vector<uintmax_t> counts;
+    uintmax_t steps{0};  // instructions executed up to the current eqrr
+    for (uintmax_t h{seq.first(steps)}; counts.size() < n;
+         h = seq.next(h, steps)) {
+        counts.push_back(steps + seq.haltSteps(h));
+        if (verbose)
+            cerr << "reg0=" << h << " halts after " << counts.back()
+                 << " instructions" << endl;
     }
-    return is;
+    return counts;
 }
 
 // Short-circuit disassembly (Johnny5 lol)
 // eqrr tests for the halting condition, so read it's registers for the value
-void solve() {
+void solve(bool brute, bool report) {
     vector<Device::Instruction> instrs;  // input instruction set to execute
     Device::Registers regs{0};           // the register set [0,1,2,3,4,5]
-    Device::Instruction instr;           // the current instruction
+    vector<Fusion::Line> code;           // the compiled (fused) program
     size_t ipReg;                        // instruction pointer register #
 
     // Parse the input program instruction set
@@ -110,6 +243,10 @@ void solve() {
     // regs[0] = 4797782;
     // set<uintmax_t> haltValues;
     unordered_set<uintmax_t> haltValues;
+    vector<uintmax_t> firstHaltValues;  // in order of appearance (cross-check)
+    BatchDevice<>::Lanes candidates{}, steps{};  // batch cross-check lanes
+    vector<uintmax_t> counts;  // exact instructions to halt, per halt value
+    size_t distinctHaltValues{0};  // # of halt values before the first repeat
     uintmax_t minHaltValue{0};  // part 1
     uintmax_t maxHaltValue{0};  // part 2
 
@@ -129,38 +266,136 @@ void solve() {
     // Where is eqrr in the program? What register is tested against reg[0]?
     cerr << "eqrrline=" << eqrrLine << " testreg=" << eqrrTestReg << endl;
 
-    // Run the input program
-    // do {
-    for (regs = {0}; regs[ipReg] < programSize; ++regs[ipReg]) {
-        // state before execution
-        // cerr << "ip=" << regs[ipReg] << " [" << regs << "] " << endl;
-
-        // execute the next instuction (indexed by ip register value)
-        instr = instrs[regs[ipReg]];
-        Device::Opcodes[instr[0]](regs, instr[1], instr[2], instr[3]);
-
-        // state after execution
-        // cerr << "ip=" << regs[ipReg] << " [" << regs << "] " << endl;
-
-        // Whenever the ip is pointing to instruction eqrr, we know the program
-        // is testing for equality b/w reg[eqrrTestReg] and reg[0] (the halt
-        // condition). The first time eqrr is encountered, we get the value for
-        // part 1. For part 2, it's the last value before a cycle occurs.
-        if (regs[ipReg] == eqrrLine) {
-            uintmax_t haltValue = regs[eqrrTestReg];
-            if (haltValues.empty())
-                minHaltValue = haltValue;  // 4797782
-            if (haltValues.count(haltValue))
-                break;  // values cycling, done!
-
-            maxHaltValue = haltValue;  // 6086461
-            haltValues.insert(haltValue);
-        }
-    }  // while (++regs[ipReg] < programSize); // increase instruction pointer
+    // Halt values run into a cycle. Part 1 is the first one; part 2 is the
+    // last one before the first repeat.
+    HaltSequence seq{ipReg, eqrrLine, eqrrTestReg, {}, {}, {}};
+    if (seq.extract(instrs)) {
+        // Brent's cycle detection on next(): O(1) memory. The value just
+        // before the first repeat is the last distinct one.
+        uintmax_t x0{seq.first()};
+        auto [mu, lam, prev]{
+            findCycle(x0, [&](uintmax_t h) { return seq.next(h); })};
+
+        minHaltValue = x0;
+        maxHaltValue = prev;
+        distinctHaltValues = mu + lam;
+        const size_t firsts{min(distinctHaltValues, candidates.size())};
+        for (uintmax_t h{x0}; firstHaltValues.size() < firsts;
+             h = seq.next(h))
+            firstHaltValues.push_back(h);
+        cerr << "# of halt values=" << mu + lam << " (cycle length " << lam
+             << ")" << endl;  // 10180
+
+        // The exact instruction counts of all the halt values (checked
+        // against the batch device below)
+        counts = haltCounts(seq, mu + lam, report);
+    } else {
+        // Interpret the whole program, storing every halt value. Optimize &
+        // fuse it, but keep eqrr on its own so its operands can be observed
+        // right after it executes.
+        code = Fusion::compile(
+            Optimizer::optimize(instrs, ipReg, {eqrrTestReg}), ipReg,
+            {eqrrLine});
+
+        // Exact instruction counts, as for the shortcut: the instructions
+        // executed up to this eqrr, plus the ones from there to the end with
+        // regs[0] equal to the halt value (so eqrr's test succeeds)
+        uintmax_t executed{0};
+        auto haltSteps{[&](uintmax_t haltValue) {
+            Device::Registers tail{regs};
+            uintmax_t tailSteps{0};
+            tail[0] = haltValue, tail[code[eqrrLine].first[3]] = 1;
+            for (++tail[ipReg]; tail[ipReg] < programSize; ++tail[ipReg]) {
+                const Fusion::Line& line = code[tail[ipReg]];
+                line.handler(tail, ipReg, line.first, line.second);
+                tailSteps += line.length;
+            }
+            return tailSteps;
+        }};
+
+        for (regs = {0}; regs[ipReg] < programSize; ++regs[ipReg]) {
+            // state before execution
+            // cerr << "ip=" << regs[ipReg] << " [" << regs << "] " << endl;
 
-    // Debug print a step (last step here)
-    cerr << "ip=" << regs[ipReg] << " [ " << regs << "] " << endl;
-    cerr << "# of halt values=" << haltValues.size() << endl;  // 10180
+            // execute the next instuction(s) (indexed by ip register value)
+            const Fusion::Line& line = code[regs[ipReg]];
+            line.handler(regs, ipReg, line.first, line.second);
+            executed += line.length;
+
+            // state after execution
+            // cerr << "ip=" << regs[ipReg] << " [" << regs << "] " << endl;
+
+            // Whenever the ip is pointing to instruction eqrr, we know the
+            // program is testing for equality b/w reg[eqrrTestReg] and reg[0]
+            // (the halt condition). The first time eqrr is encountered, we get
+            // the value for part 1. For part 2, it's the last value before a
+            // cycle occurs.
+            if (regs[ipReg] == eqrrLine) {
+                uintmax_t haltValue = regs[eqrrTestReg];
+                if (haltValues.empty())
+                    minHaltValue = haltValue;  // 4797782
+                if (haltValues.count(haltValue))
+                    break;  // values cycling, done!
+
+                maxHaltValue = haltValue;  // 6086461
+                haltValues.insert(haltValue);
+                counts.push_back(executed + haltSteps(haltValue));
+                if (report)
+                    cerr << "reg0=" << haltValue << " halts after "
+                         << counts.back() << " instructions" << endl;
+                if (firstHaltValues.size() < candidates.size())
+                    firstHaltValues.push_back(haltValue);
+            }
+        }  // while (++regs[ipReg] < programSize); // increase ip
+
+        // Debug print a step (last step here)
+        cerr << "ip=" << regs[ipReg] << " [ " << regs << "] " << endl;
+        cerr << "# of halt values=" << haltValues.size() << endl;  // 10180
+        distinctHaltValues = haltValues.size();
+    }
+    if (!counts.empty())
+        cerr << "fewest=" << counts.front() << " most=" << counts.back()
+             << " instructions (if regs[0] only matters at eqrr)" << endl;
+
+    // Cross-check the shortcut by brute force: run the first few halt values
+    // as initial regs[0] in lockstep (with --brute, the last one too: the
+    // part 2 value, which runs about as long as interpreting the program).
+    // Each must halt, in strictly more instructions than the one before it
+    // (so part 1 halts the fastest, and part 2 the slowest of them), and in
+    // exactly as many as the instruction count oracle says.
+    vector<uintmax_t> sample{firstHaltValues};
+    vector<size_t> sampleIndex(sample.size());  // # in the halt sequence
+    iota(sampleIndex.begin(), sampleIndex.end(), size_t{0});
+    if (brute && distinctHaltValues > sample.size()) {
+        if (sample.size() == candidates.size())
+            sample.pop_back(), sampleIndex.pop_back();
+        sample.push_back(maxHaltValue);
+        sampleIndex.push_back(distinctHaltValues - 1);
+    }
+    bool fewestFirst{true};
+    if (!sample.empty()) {
+        // spare lanes rerun the first value (the fastest to halt)
+        const uintmax_t maxSteps{brute ? 10'000'000'000u : 100'000'000u};
+        candidates.fill(sample[0]);
+        copy(sample.begin(), sample.end(), candidates.begin());
+        steps = BatchDevice<>::run(instrs, ipReg, candidates, maxSteps);
+        const auto used{steps.begin() + sample.size()};
+        for (size_t l = 0; l < sample.size(); ++l) {
+            cerr << "reg0=" << candidates[l] << " halts after " << steps[l]
+                 << " instructions" << endl;
+            fewestFirst &= steps[l] < maxSteps;  // halted within the budget
+            if (sampleIndex[l] < counts.size())  // matches the oracle too
+                fewestFirst &= steps[l] == counts[sampleIndex[l]];
+        }
+        fewestFirst &=
+            adjacent_find(steps.begin(), used, greater_equal<>()) == used;
+    }
+    cerr << "batch cross-check " << (fewestFirst ? "ok" : "FAILED") << endl;
+    if (!fewestFirst) {
+        // the halt values don't halt the program in order: they're no answer
+        cerr << "The halt values failed validation, no answers" << endl;
+        return;
+    }
 
     // Part 1:What is the lowest non-negative integer value for register 0 that
     // causes the program to halt after executing the fewest instructions?
@@ -174,14 +409,17 @@ void solve() {
     cout << "[Part 02] = " << maxHaltValue << endl;  // 6086461
 }
 
-// Main: Time the solver.
-int main() {
+// Main: Time the solver. (--brute: also brute force the part 2 value,
+// --counts: report the exact instruction count of every halt value, and
+// brute force the part 2 value to validate them)
+int main(int argc, char* argv[]) {
     // Speed up C++ io by unsyncing with C stdio and untie cin/cout.
     ios_base::sync_with_stdio(false);
     std::cin.tie(0);
     // Time the solve() function in milliseconds.
     auto start_time = std::chrono::high_resolution_clock::now();
-    solve();
+    const string flag{argc > 1 ? argv[1] : ""};
+    solve(flag == "--brute" || flag == "--counts", flag == "--counts");
     auto end_time = std::chrono::high_resolution_clock::now();
     auto ms_count = std::chrono::duration_cast<std::chrono::milliseconds>(
                         end_time - start_time)
@@ -7,21 +7,13 @@
 #include <iostream>
 #include <istream>
 #include <iterator>
-#include <queue>
-#include <set>
-#include <tuple>
 #include <vector>
-using namespace std;
 
-// 4-tuple with less-than comparison operator (for the priority_queue)
-// Returns the reversed comparison since priority_queue returns the
-// maximal element and Dijkstra uses the minimal
-struct Node {
-    int x, y, tool, cost;  // (x,y) coord, tool-type, path-time cost
-    bool operator<(const Node& rhs) const { return cost > rhs.cost; }
-};
+// grid & shortest path search helpers
+#include "search.hpp"
+using namespace std;
 
-// Dijkstra's shortest path cost on weighted graph
+// A* shortest path cost on weighted graph (bucket queue: costs are 1 or 7)
 // Edge cost is the time it takes to move to another location in the cave
 void solve() {
     // Example // solution: 114, 45
@@ -85,7 +77,7 @@ void solve() {
         for (int x = 0; x <= tgtX; x++)
             totalRiskLevel += (erosion[y][x] % 3);
 
-    // Part 2: Dijkstra's shortest path on weighted graph
+    // Part 2: A* shortest path on weighted graph
     // Edge cost: time to move to next node/location
 
     // rocky, wet, narrow = {0,1,2} cave type (erosion mod 3)
@@ -93,47 +85,42 @@ void solve() {
     enum { none, torch, gear };  // tool types
     vector<int> tools{none, torch, gear};
 
-    // vector<int> dY{-1, 0, 1, 0}; // up, down
-    // vector<int> dX{0, 1, 0, -1}; // right, left
-    vector<pair<int, int>> nsew{{-1, 0}, {0, 1}, {1, 0}, {0, -1}};
-
-    // Dijkstra Shortest Path Algorithm (on weighted graph)
-    int fewestMinutes{0};               // part 2 memo (lowest path cost)
-    priority_queue<Node> PQ;            // {x,y,tool,cost}
-    set<tuple<int, int, int>> visited;  // {x,y,tool}
-    PQ.push({0, 0, torch, 0});          // start at cave mouth with torch
-    while (!PQ.empty()) {
-        auto [x, y, tool, cost] = PQ.top();
-        PQ.pop();
-
-        // reached our target with the torch equipped, done!
-        if ((y == tgtY) && (x == tgtX) && (tool == torch)) {
-            fewestMinutes = cost;
-            break;
-        }
-
-        // skip visited nodes, memo new ones
-        if (visited.count({x, y, tool}))
-            continue;
-        else
-            visited.insert({x, y, tool});
-
-        // Try each tool type: time cost +7 minutes
-        int caveType = erosion[y][x] % 3;
+    // search state: (cave location, tool) as a flat index
+    Grid cave{size_t(maxY), size_t(maxX)};
+    auto state{[&](int x, int y, int tool) {
+        return cave.index(y, x) * tools.size() + tool;
+    }};
+
+    // Try each tool type: time cost +7 minutes
+    // Try each direction: time cost +1 minute
+    auto moves{[&](size_t s, auto visit) {
+        size_t loc{s / tools.size()};
+        int tool = s % tools.size();
+        int caveType = erosion[loc / maxX][loc % maxX] % 3;
         for (int const& toolType : tools)
-            if (caveType != toolType)
-                PQ.push({x, y, toolType, (cost + 7)});
-
-        // Try each direction: time cost +1 minute
-        for (pair<int, int> const& dx_dy : nsew) {
-            auto [dx, dy] = dx_dy;
-            dx += x, dy += y;
-            int caveType = erosion[dy][dx] % 3;
-            bool inCave{(0 <= dx) && (dx < maxX) && (0 <= dy) && (dy < maxY)};
-            if (inCave && (caveType != tool))
-                PQ.push({dx, dy, tool, (cost + 1)});
-        }
-    }
+            if (caveType != toolType && toolType != tool)
+                visit(loc * tools.size() + toolType, 7);
+        cave.neighbors(loc, [&](size_t nloc) {
+            if (erosion[nloc / maxX][nloc % maxX] % 3 != tool)
+                visit(nloc * tools.size() + tool, 1);
+        });
+    }};
+
+    // Heuristic: manhattan distance, plus a tool switch if not on the torch
+    // (consistent: a move changes it by <= 1, a tool switch by <= 7)
+    auto minutesLeft{[&](size_t s) {
+        size_t loc{s / tools.size()};
+        int x = loc % maxX, y = loc / maxX;
+        return Search::Dist(abs(x - tgtX) + abs(y - tgtY) +
+                            (int(s % tools.size()) != torch ? 7 : 0));
+    }};
+
+    // A* Shortest Path Algorithm (on weighted graph), from the cave mouth
+    // with the torch until reaching the target with the torch equipped
+    Search search{cave.size() * tools.size()};
+    size_t goal{state(tgtX, tgtY, torch)};
+    int fewestMinutes = search.astar(state(0, 0, torch), moves, 7, minutesLeft,
+                                     [&](size_t s) { return s == goal; });
 
     // Part 1: What is the total risk level for the smallest rectangle that
     // includes the cave mouth (0,0) and the target's coordinates?
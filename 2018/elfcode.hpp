@@ -0,0 +1,498 @@
+/******************************************************************************
+ElfCode device shared by the days that run a program with a bound ip register
+(day 19, day 21): the opcode table, the program parser, and a fusion pass that
+replaces common adjacent instruction pairs with a single compiled handler.
+******************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*****************************************************************************/
+
+// Define the device to simulate as per the given specs.
+struct Device {
+    typedef std::array<uintmax_t, 6> Registers;    //  [0, 1, 2, 3, 4, 5]
+    typedef std::array<uintmax_t, 4> Instruction;  //  [OP, Ain, Bin, Cout]
+    typedef void (*Op)(Registers&, size_t, size_t, size_t);  // fn pointer
+
+    Registers regs;  // set of 6 registers in the device
+
+    // opcode template: register vs. immediate "specialization" via bool flags
+    template <typename F, bool RegA = true, bool RegB = true>
+    static void OPR(Registers& regs, size_t A, size_t B, size_t C) {
+        F function;  // the operation to execute
+        regs[C] = function(RegA ? regs[A] : A, RegB ? regs[B] : B);  // execute
+    }
+
+    // the opcode definitions
+    constexpr static std::array<Op, 16> Opcodes = {{
+        OPR<std::plus<size_t>, true, true>,         // addr
+        OPR<std::plus<size_t>, true, false>,        // addi
+        OPR<std::multiplies<size_t>, true, true>,   // mulr
+        OPR<std::multiplies<size_t>, true, false>,  // muli
+        OPR<std::bit_and<size_t>, true, true>,      // banr
+        OPR<std::bit_and<size_t>, true, false>,     // bani
+        OPR<std::bit_or<size_t>, true, true>,       // borr
+        OPR<std::bit_or<size_t>, true, false>,      // bori
+        OPR<std::greater<size_t>, false, true>,     // gtir
+        OPR<std::greater<size_t>, true, false>,     // gtri
+        OPR<std::greater<size_t>, true, true>,      // gtrr
+        OPR<std::equal_to<size_t>, false, true>,    // eqir
+        OPR<std::equal_to<size_t>, true, false>,    // eqri
+        OPR<std::equal_to<size_t>, true, true>,     // eqrr
+
+        // setr: lambda (constexpr -> void)
+        [](Registers& regs, size_t A, size_t, size_t C) { regs[C] = regs[A]; },
+
+        // seti: lambda (constexpr -> void)
+        [](Registers& regs, size_t A, size_t, size_t C) { regs[C] = A; },
+
+    }};  // end Opcodes
+};       // end Device struct
+
+// the opcode numbers, in Device::Opcodes order
+enum Opcode : size_t {
+    addr, addi, mulr, muli, banr, bani, borr, bori,
+    gtir, gtri, gtrr, eqir, eqri, eqrr, setr, seti
+};
+
+// Convert instruction string names to integer opcodes
+size_t opNameToOpcode(const std::string& opName) {
+    std::vector<std::string> opNames(
+        {"addr", "addi", "mulr", "muli", "banr", "bani", "borr", "bori",
+         "gtir", "gtri", "gtrr", "eqir", "eqri", "eqrr", "setr", "seti"});
+    auto opIndex(std::find(opNames.begin(), opNames.end(), opName));
+    return std::distance(opNames.begin(), opIndex);
+}
+
+// Output a register set's full state
+std::ostream& operator<<(std::ostream& os, const Device::Registers& regs) {
+    for (uintmax_t const& state : regs)
+        os << state << " ";
+    return os;
+}
+
+// Parse the input program instruction set
+// #ip 2        <- instruction pointer value register # (read by the caller)
+// seti 123 0 3 <- the instr/opcode executed [OP, Ain, Bin, Cout]
+// ...
+std::istream& operator>>(std::istream& is,
+                         std::vector<Device::Instruction>& v) {
+    for (std::string opName; is >> opName;) {
+        Device::Instruction instr;
+        instr[0] = opNameToOpcode(opName);
+        for (auto i = 1; i < 4; i++)
+            is >> instr[i];
+        v.push_back(instr);
+    }
+    return is;
+}
+
+/*****************************************************************************/
+
+// Superinstructions: a pair of adjacent instructions where the second one
+// writes the ip (a branch) is executed by one handler instead of two
+// dispatches. The pairs to fuse are listed in a constexpr pattern table and a
+// handler is instantiated for each entry at compile time, so both opcodes are
+// known constants inside it and get inlined.
+struct Fusion {
+    typedef Device::Registers Registers;
+    typedef Device::Instruction Instruction;
+    typedef void (*Handler)(Registers&, size_t, const Instruction&,
+                            const Instruction&);
+
+    // one compiled program line: a single instruction or a fused pair
+    struct Line {
+        Handler handler;     // executes 1 or 2 instructions
+        Instruction first;   // the instruction at this line
+        Instruction second;  // the next line's instruction (if fused)
+        size_t length;       // # of instructions executed (1 or 2)
+    };
+
+    // the adjacent opcode pairs to fuse (when the 2nd one writes the ip)
+    // (the addi forms are what the Optimizer turns `addr t ip ip` into)
+    constexpr static std::array<std::pair<size_t, size_t>, 15> Patterns = {{
+        {gtir, addr},  // conditional skip: gtir t; addr t ip ip
+        {gtri, addr},  // conditional skip: gtri t; addr t ip ip
+        {gtrr, addr},  // conditional skip: gtrr t; addr t ip ip
+        {eqir, addr},  // conditional skip: eqir t; addr t ip ip
+        {eqri, addr},  // conditional skip: eqri t; addr t ip ip
+        {eqrr, addr},  // conditional skip: eqrr t; addr t ip ip
+        {gtir, addi},  // conditional skip: gtir t; addi t <line> ip
+        {gtri, addi},  // conditional skip: gtri t; addi t <line> ip
+        {gtrr, addi},  // conditional skip: gtrr t; addi t <line> ip
+        {eqir, addi},  // conditional skip: eqir t; addi t <line> ip
+        {eqri, addi},  // conditional skip: eqri t; addi t <line> ip
+        {eqrr, addi},  // conditional skip: eqrr t; addi t <line> ip
+        {addi, addi},  // counter step then skip: addi ip 1 ip
+        {addi, seti},  // counter step then loop back: seti X ip
+        {setr, seti},  // register move then loop back: seti X ip
+    }};
+
+    // single instruction handler
+    template <size_t Op>
+    static void SINGLE(Registers& regs, size_t, const Instruction& i1,
+                       const Instruction&) {
+        Device::Opcodes[Op](regs, i1[1], i1[2], i1[3]);
+    }
+
+    // fused pair handler: the 1st op never writes the ip, so the 2nd one is
+    // always the next line executed
+    template <size_t Op1, size_t Op2>
+    static void FUSED(Registers& regs, size_t ipReg, const Instruction& i1,
+                      const Instruction& i2) {
+        Device::Opcodes[Op1](regs, i1[1], i1[2], i1[3]);
+        ++regs[ipReg];
+        Device::Opcodes[Op2](regs, i2[1], i2[2], i2[3]);
+    }
+
+    // handler tables, generated from the opcode list & pattern table
+    template <size_t... I>
+    constexpr static std::array<Handler, sizeof...(I)> singles(
+        std::index_sequence<I...>) {
+        return {{SINGLE<I>...}};
+    }
+    template <size_t... I>
+    constexpr static std::array<Handler, sizeof...(I)> fuseds(
+        std::index_sequence<I...>) {
+        return {{FUSED<Patterns[I].first, Patterns[I].second>...}};
+    }
+
+    // Compile a program: every line gets its own entry (so jumps into the
+    // middle of a pair still work), and a line whose successor matches a
+    // pattern gets the fused handler. Lines in `barriers` never start a fused
+    // pair, so the caller can inspect the registers right after they execute.
+    static std::vector<Line> compile(const std::vector<Instruction>& instrs,
+                                     size_t ipReg,
+                                     const std::set<size_t>& barriers = {}) {
+        constexpr auto Singles{singles(std::make_index_sequence<16>{})};
+        constexpr auto Fuseds{
+            fuseds(std::make_index_sequence<Patterns.size()>{})};
+        std::vector<Line> code;
+        for (size_t ip = 0; ip < instrs.size(); ++ip) {
+            const Instruction& i1{instrs[ip]};
+            Line line{Singles[i1[0]], i1, i1, 1};
+            if (ip + 1 < instrs.size() && i1[3] != ipReg &&
+                !barriers.count(ip)) {
+                const Instruction& i2{instrs[ip + 1]};
+                for (size_t p = 0; p < Patterns.size(); ++p)
+                    if (Patterns[p] == std::make_pair(i1[0], i2[0]) &&
+                        i2[3] == ipReg)
+                        line = {Fuseds[p], i1, i2, 2};
+            }
+            code.push_back(line);
+        }
+        return code;
+    }
+};  // end Fusion struct
+
+/*****************************************************************************/
+
+// Optimizer: rewrites a program line for line (so line numbers, jumps, and
+// the # of instructions executed on any path are unchanged):
+//  1. builds the control-flow graph from the ip register writes,
+//  2. propagates constants along it (the ip register is the line # itself),
+//     turning register operands with known values into immediates and
+//     instructions with a known result into seti,
+//  3. turns register stores that are never read into no-ops.
+// Registers start at 0 except register 0, whose possible initial values are
+// given by `reg0`. Registers listed as `observed` (read by the caller) are
+// never dead. If a jump target can't be resolved, the program is returned
+// unchanged.
+struct Optimizer {
+    typedef Device::Instruction Instruction;
+    typedef std::vector<Instruction> Program;
+
+    // abstract register value: unknown yet < constant < 0 or 1 < anything
+    struct Value {
+        enum Kind { Undef, Const, Bool, Any } kind;
+        uintmax_t c;
+        bool operator==(const Value& v) const {
+            return kind == v.kind && (kind != Const || c == v.c);
+        }
+    };
+    typedef std::array<Value, 6> State;
+
+    // operation kind & register/immediate flags of every opcode
+    enum Kind { Add, Mul, And, Or, Gt, Eq, Set };
+    struct Form {
+        Kind kind;
+        bool regA, regB;
+    };
+    constexpr static std::array<Form, 16> Forms = {{
+        {Add, 1, 1}, {Add, 1, 0}, {Mul, 1, 1}, {Mul, 1, 0},  // addr .. muli
+        {And, 1, 1}, {And, 1, 0}, {Or, 1, 1},  {Or, 1, 0},   // banr .. bori
+        {Gt, 0, 1},  {Gt, 1, 0},  {Gt, 1, 1},                // gtir .. gtrr
+        {Eq, 0, 1},  {Eq, 1, 0},  {Eq, 1, 1},                // eqir .. eqrr
+        {Set, 1, 0}, {Set, 0, 0},                            // setr, seti
+    }};
+
+    // least upper bound of two values
+    static Value join(const Value& a, const Value& b) {
+        auto isBool{[](const Value& v) {
+            return v.kind == Value::Bool || (v.kind == Value::Const && v.c < 2);
+        }};
+        if (a.kind == Value::Undef || a == b)
+            return b;
+        if (b.kind == Value::Undef)
+            return a;
+        if (isBool(a) && isBool(b))
+            return {Value::Bool, 0};
+        return {Value::Any, 0};
+    }
+
+    // evaluate an operation on constants
+    static uintmax_t eval(Kind kind, uintmax_t a, uintmax_t b) {
+        switch (kind) {
+            case Add: return a + b;
+            case Mul: return a * b;
+            case And: return a & b;
+            case Or: return a | b;
+            case Gt: return a > b;
+            case Eq: return a == b;
+            default: return a;
+        }
+    }
+
+    // operand values of an instruction in a given state
+    static std::pair<Value, Value> operands(const Instruction& i,
+                                            const State& s) {
+        const Form& f{Forms[i[0]]};
+        Value a{f.regA ? s[i[1]] : Value{Value::Const, i[1]}};
+        Value b{f.regB ? s[i[2]] : Value{Value::Const, i[2]}};
+        if (f.kind == Set)
+            b = {Value::Const, 0};  // B is ignored
+        return {a, b};
+    }
+
+    // abstract result of an instruction in a given state
+    static Value result(const Instruction& i, const State& s) {
+        auto [a, b]{operands(i, s)};
+        Kind kind{Forms[i[0]].kind};
+        if (a.kind == Value::Const && b.kind == Value::Const)
+            return {Value::Const, eval(kind, a.c, b.c)};
+        if (kind == Gt || kind == Eq)
+            return {Value::Bool, 0};
+        if (kind == Set)
+            return a;
+        return {Value::Any, 0};
+    }
+
+    // Successor lines of line `ip` (>= program size means halt). Returns
+    // false if the ip write can't be resolved to a small set of targets.
+    static bool successors(const Instruction& i, const State& s, size_t ipReg,
+                           std::vector<uintmax_t>& succ) {
+        succ.clear();
+        Value v{i[3] == ipReg ? result(i, s) : s[ipReg]};
+        if (v.kind == Value::Const) {
+            succ = {v.c + 1};
+            return true;
+        }
+
+        // conditional skip: ip = 0/1 + constant
+        auto [a, b]{operands(i, s)};
+        if (Forms[i[0]].kind == Add) {
+            if (a.kind == Value::Bool && b.kind == Value::Const)
+                std::swap(a, b);
+            if (a.kind == Value::Const && b.kind == Value::Bool) {
+                succ = {a.c + 1, a.c + 2};
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // rewrite an instruction with its known operand values folded in
+    static Instruction fold(const Instruction& i, const State& s) {
+        Value v{result(i, s)};
+        if (v.kind == Value::Const)
+            return {seti, v.c, 0, i[3]};
+
+        // known register operands become immediates
+        const Form& f{Forms[i[0]]};
+        auto [a, b]{operands(i, s)};
+        bool regA{f.regA && a.kind != Value::Const};
+        bool regB{f.regB && b.kind != Value::Const};
+        uintmax_t A{regA ? i[1] : a.c}, B{regB ? i[2] : b.c};
+        if (f.kind <= Or && !regA && regB)
+            std::swap(A, B), std::swap(regA, regB);  // commutative: reg first
+
+        // find the opcode with that form (if there is one)
+        for (size_t op = 0; op < Forms.size(); ++op)
+            if (Forms[op].kind == f.kind && Forms[op].regA == regA &&
+                (f.kind == Set || Forms[op].regB == regB))
+                return {op, A, B, i[3]};
+        return i;
+    }
+
+    // Constant propagation over the control-flow graph (worklist): fills in
+    // the register values on entry to each line (ip register Undef = line is
+    // unreachable) and each line's successors. False on an unresolved jump.
+    typedef std::vector<std::vector<uintmax_t>> Graph;
+    static bool propagate(const Program& instrs, size_t ipReg, Value reg0,
+                          std::vector<State>& in, Graph& succs) {
+        const size_t n{instrs.size()};
+        in.assign(n, State{});
+        for (auto& s : in)
+            s.fill({Value::Undef, 0});
+        succs.assign(n, {});
+
+        std::vector<size_t> work;
+        auto flow{[&](uintmax_t to, State s) {
+            if (to >= n)
+                return;  // halts
+            s[ipReg] = {Value::Const, to};
+            State joined;
+            for (size_t r = 0; r < s.size(); ++r)
+                joined[r] = join(in[to][r], s[r]);
+            if (!(joined == in[to]))
+                in[to] = joined, work.push_back(to);
+        }};
+        State entry;
+        entry.fill({Value::Const, 0});
+        entry[0] = reg0;
+        flow(0, entry);
+        while (!work.empty()) {
+            size_t ip{work.back()};
+            work.pop_back();
+            const State& s{in[ip]};
+            if (!successors(instrs[ip], s, ipReg, succs[ip]))
+                return false;
+            State out{s};
+            out[instrs[ip][3]] = result(instrs[ip], s);
+            for (uintmax_t to : succs[ip])
+                flow(to, out);
+        }
+        return true;
+    }
+
+    // Backward liveness: the registers that may still be read after each
+    // line executes (live-out). Observed registers are always live.
+    typedef std::array<bool, 6> Live;
+    static std::vector<Live> liveness(const Program& code, size_t ipReg,
+                                      const Graph& succs,
+                                      const std::set<size_t>& observed) {
+        const size_t n{code.size()};
+        std::vector<Live> liveIn(n), liveOut(n);
+        for (bool grew{true}; grew;) {
+            grew = false;
+            for (size_t ip = n; ip-- > 0;) {
+                Live live{};
+                for (size_t r : observed)
+                    live[r] = true;
+                for (uintmax_t to : succs[ip])
+                    for (size_t r = 0; to < n && r < live.size(); ++r)
+                        live[r] = live[r] || liveIn[to][r];
+                liveOut[ip] = live;
+
+                // live-in = uses + (live-out - def)
+                const Form& f{Forms[code[ip][0]]};
+                live[code[ip][3]] = false;
+                if (f.regA)
+                    live[code[ip][1]] = true;
+                if (f.regB && f.kind != Set)
+                    live[code[ip][2]] = true;
+                live[ipReg] = true;
+                if (live != liveIn[ip])
+                    liveIn[ip] = live, grew = true;
+            }
+        }
+        return liveOut;
+    }
+
+    static Program optimize(const Program& instrs, size_t ipReg,
+                            const std::set<size_t>& observed = {},
+                            Value reg0 = {Value::Any, 0}) {
+        std::vector<State> in;
+        Graph succs;
+        if (!propagate(instrs, ipReg, reg0, in, succs))
+            return instrs;  // unresolved jump: leave the program alone
+
+        // fold constants into every reachable line
+        Program code{instrs};
+        for (size_t ip = 0; ip < code.size(); ++ip)
+            if (in[ip][ipReg].kind == Value::Const)
+                code[ip] = fold(instrs[ip], in[ip]);
+
+        // dead-store elimination: repeat until no more stores die
+        for (bool changed{true}; changed;) {
+            changed = false;
+            std::vector<Live> live{liveness(code, ipReg, succs, observed)};
+            for (size_t ip = 0; ip < code.size(); ++ip) {
+                size_t C{code[ip][3]};
+                if (C != ipReg && !live[ip][C] &&
+                    in[ip][ipReg].kind == Value::Const)
+                    code[ip] = {seti, ip, 0, ipReg}, changed = true;  // nop
+            }
+        }
+        return code;
+    }
+};  // end Optimizer struct
+
+/*****************************************************************************/
+
+// Counting loops: the ElfCode idiom for integer division,
+//     for (c = c0; (c + 1) * K <= n; ++c) ;   (so c = max(c0, n / K))
+// recognized in an optimized program (jumps are seti, skips addi t <line> ip):
+//     h+0: addi c 1 t
+//     h+1: muli t K t
+//     h+2: gtrr t n t
+//     h+3: addi t h+3 ip   <- skip the next line when done
+//     h+4: seti h+5 _ ip   <- goto h+6
+//     h+5: seti X _ ip     <- goto X+1 (the loop exit)
+//     h+6: addi c 1 c
+//     h+7: seti h-1 _ ip   <- goto h
+// Jumping to the exit with the loop's final registers instead of iterating
+// gives the same state, and the # of instructions it would have executed.
+struct CountingLoop {
+    size_t head, exit;            // first line, line executed after the loop
+    size_t counter, temp, bound;  // registers c, t, n
+    uintmax_t factor;             // K
+
+    // instructions per iteration that continues / that leaves the loop
+    constexpr static uintmax_t BodyLength{7}, LastLength{5};
+
+    // Fast-forward from the loop head to its exit (ip register included).
+    // Returns the # of instructions the loop would have executed.
+    uintmax_t run(Device::Registers& regs, size_t ipReg) const {
+        uintmax_t c0{regs[counter]};
+        uintmax_t c{std::max(c0, regs[bound] / factor)};
+        regs[counter] = c;
+        regs[temp] = 1;
+        regs[ipReg] = exit;
+        return (c - c0) * BodyLength + LastLength;
+    }
+
+    // find all the counting loops of an (optimized) program
+    static std::vector<CountingLoop> find(const Optimizer::Program& code,
+                                          size_t ipReg) {
+        std::vector<CountingLoop> loops;
+        const uintmax_t any{~uintmax_t{0}};  // operand wildcard
+        auto is{[&](size_t ip, size_t op, uintmax_t A, uintmax_t B,
+                    uintmax_t C) {
+            return code[ip][0] == op && (A == any || code[ip][1] == A) &&
+                   (B == any || code[ip][2] == B) && code[ip][3] == C;
+        }};
+        for (size_t h = 1; h + 7 < code.size(); ++h) {
+            size_t c{code[h][1]}, t{code[h][3]}, n{code[h + 2][2]};
+            uintmax_t K{code[h + 1][2]};
+            std::set<size_t> regs{c, t, n, ipReg};
+            if (regs.size() == 4 && K > 0 && is(h, addi, c, 1, t) &&
+                is(h + 1, muli, t, K, t) && is(h + 2, gtrr, t, n, t) &&
+                is(h + 3, addi, t, h + 3, ipReg) &&
+                is(h + 4, seti, h + 5, any, ipReg) &&
+                is(h + 5, seti, any, any, ipReg) &&
+                is(h + 6, addi, c, 1, c) && is(h + 7, seti, h - 1, any, ipReg))
+                loops.push_back({h, code[h + 5][1] + 1, c, t, n, K});
+        }
+        return loops;
+    }
+};  // end CountingLoop struct
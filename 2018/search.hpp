@@ -0,0 +1,142 @@
+/******************************************************************************
+Graph search over a flat state-index space (grid cells, cells x tools, ...):
+breadth-first search from one or many sources, and Dial's bucket queue for
+small integer edge weights with an optional A* heuristic. Distances live in
+an epoch-stamped array, so starting a new search doesn't clear anything.
+******************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/*****************************************************************************/
+
+// Epoch-stamped array: an entry only counts as set if its stamp matches the
+// current epoch, so reset() "clears" the whole array in O(1)
+template <typename T>
+struct StampedArray {
+    std::vector<uint32_t> stamps;  // epoch each entry was last set in
+    std::vector<T> values;         // the entries
+    uint32_t epoch{1};             // current epoch (0 = never set)
+
+    explicit StampedArray(size_t n = 0) : stamps(n, 0), values(n) {}
+
+    void reset() {
+        if (++epoch == 0)  // wrapped around: really clear the stamps
+            std::fill(stamps.begin(), stamps.end(), 0), epoch = 1;
+    }
+    bool has(size_t i) const { return stamps[i] == epoch; }
+    const T& operator[](size_t i) const { return values[i]; }
+    void set(size_t i, const T& v) { stamps[i] = epoch, values[i] = v; }
+};
+
+// 2D grid <-> flat state index (row-major, so index order is reading order)
+struct Grid {
+    size_t rows, cols;
+
+    size_t size() const { return rows * cols; }
+    size_t index(size_t y, size_t x) const { return y * cols + x; }
+
+    // visit the in-bounds 4-neighbours of a cell in reading order
+    template <typename Visit>
+    void neighbors(size_t i, Visit visit) const {
+        size_t y{i / cols}, x{i % cols};
+        if (y > 0)
+            visit(i - cols);
+        if (x > 0)
+            visit(i - 1);
+        if (x + 1 < cols)
+            visit(i + 1);
+        if (y + 1 < rows)
+            visit(i + cols);
+    }
+};
+
+/*****************************************************************************/
+
+// The searches. Neighbours are enumerated by a callable: nbrs(state, visit)
+// calls visit(next) for bfs(), or visit(next, weight) for dial()/astar().
+// The arrays are reused between searches of the same state space.
+struct Search {
+    typedef uint32_t Dist;
+    constexpr static Dist Unreached{std::numeric_limits<Dist>::max()};
+
+    StampedArray<Dist> dist;                   // distances of the last search
+    std::vector<size_t> queue;                 // bfs frontier
+    std::vector<std::vector<size_t>> buckets;  // bucket queue ring
+
+    explicit Search(size_t states) : dist(states) {}
+
+    bool reached(size_t s) const { return dist.has(s); }
+    Dist operator[](size_t s) const { return reached(s) ? dist[s] : Unreached; }
+
+    // multi-source BFS: distance of every reachable state to its nearest
+    // source. The reached states are left in `queue` in order of distance.
+    template <typename It, typename Nbrs>
+    void bfs(It first, It last, Nbrs nbrs) {
+        dist.reset();
+        queue.clear();
+        for (; first != last; ++first)
+            if (!dist.has(*first))
+                dist.set(*first, 0), queue.push_back(*first);
+        for (size_t head = 0; head < queue.size(); ++head) {
+            Dist d{dist[queue[head]] + 1};
+            nbrs(queue[head], [&](size_t t) {
+                if (!dist.has(t))
+                    dist.set(t, d), queue.push_back(t);
+            });
+        }
+    }
+    template <typename Nbrs>
+    void bfs(size_t source, Nbrs nbrs) {
+        bfs(&source, &source + 1, nbrs);
+    }
+
+    // A* for integer edge weights in [1, maxWeight], with a bucket queue keyed
+    // by f = g + h instead of a heap. h must be consistent in both directions
+    // (|h(s) - h(t)| <= weight(s, t)), so any f pushed lies within 2*maxWeight
+    // of the f being expanded and a ring of buckets suffices. Returns the
+    // distance to the first state satisfying goal(), or Unreached.
+    template <typename Nbrs, typename Heuristic, typename Goal>
+    Dist astar(size_t source, Nbrs nbrs, Dist maxWeight, Heuristic h,
+               Goal goal) {
+        const size_t ring{2 * size_t{maxWeight} + 1};
+        dist.reset();
+        buckets.resize(ring);
+        for (auto& bucket : buckets)
+            bucket.clear();
+
+        size_t pending{1};
+        dist.set(source, 0);
+        buckets[h(source) % ring].push_back(source);
+        for (size_t f = h(source); pending > 0; ++f) {
+            auto& bucket{buckets[f % ring]};
+            while (!bucket.empty()) {
+                size_t s{bucket.back()};
+                bucket.pop_back(), --pending;
+                Dist g{dist[s]};
+                if (g + h(s) != f)
+                    continue;  // stale entry: s was reached cheaper since
+                if (goal(s))
+                    return g;
+                nbrs(s, [&](size_t t, Dist w) {
+                    if (!dist.has(t) || g + w < dist[t]) {
+                        dist.set(t, g + w);
+                        buckets[(g + w + h(t)) % ring].push_back(t);
+                        ++pending;
+                    }
+                });
+            }
+        }
+        return Unreached;
+    }
+
+    // Dial's algorithm: A* without a heuristic
+    template <typename Nbrs, typename Goal>
+    Dist dial(size_t source, Nbrs nbrs, Dist maxWeight, Goal goal) {
+        return astar(source, nbrs, maxWeight, [](size_t) { return Dist{0}; },
+                     goal);
+    }
+};